@@ -36,6 +36,25 @@ static void simdsort(benchmark::State &state, Args &&...args)
     }
 }
 
+template <typename T, class... Args>
+static void simd_parallelsort(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<T> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::qsort_parallel(arr.data(), arrsize);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
 template <typename T, class... Args>
 static void scalar_revsort(benchmark::State &state, Args &&...args)
 {
@@ -74,8 +93,69 @@ static void simd_revsort(benchmark::State &state, Args &&...args)
     }
 }
 
+/* qsort with the dispatch capped at one ISA, skipped if the CPU lacks it */
+template <typename T, class... Args>
+static void simdsort_isa(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    std::string isa = std::get<2>(args_tuple);
+    if (!x86simdsort::set_preferred_isa(isa)
+        || x86simdsort::get_dispatched_isa<T>("qsort") != isa) {
+        x86simdsort::set_preferred_isa("");
+        state.SkipWithError("ISA is not supported on this CPU");
+        return;
+    }
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<T> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::qsort(arr.data(), arrsize);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+    x86simdsort::set_preferred_isa("");
+}
+
+#define BENCH_ISA_QSORT(type, isa) \
+    MY_BENCHMARK_CAPTURE(simdsort_isa, \
+                         type, \
+                         isa##_random_1k, \
+                         1024, \
+                         std::string("random"), \
+                         std::string(#isa)); \
+    MY_BENCHMARK_CAPTURE(simdsort_isa, \
+                         type, \
+                         isa##_random_100k, \
+                         100000, \
+                         std::string("random"), \
+                         std::string(#isa)); \
+    MY_BENCHMARK_CAPTURE(simdsort_isa, \
+                         type, \
+                         isa##_random_1m, \
+                         1000000, \
+                         std::string("random"), \
+                         std::string(#isa)); \
+    MY_BENCHMARK_CAPTURE(simdsort_isa, \
+                         type, \
+                         isa##_smallrange_1m, \
+                         1000000, \
+                         std::string("smallrange"), \
+                         std::string(#isa));
+
+#define BENCH_ALL_ISA_QSORT(type) \
+    BENCH_ISA_QSORT(type, avx512_zen4) \
+    BENCH_ISA_QSORT(type, avx512_skx) \
+    BENCH_ISA_QSORT(type, avx10_256) \
+    BENCH_ISA_QSORT(type, avx2)
+
 #define BENCH_BOTH_QSORT(type) \
     BENCH_SORT(simdsort, type) \
+    BENCH_SORT(simd_parallelsort, type) \
     BENCH_SORT(scalarsort, type) \
     BENCH_SORT(simd_revsort, type) \
     BENCH_SORT(scalar_revsort, type)
@@ -88,6 +168,11 @@ BENCH_BOTH_QSORT(uint16_t)
 BENCH_BOTH_QSORT(int16_t)
 BENCH_BOTH_QSORT(float)
 BENCH_BOTH_QSORT(double)
+
+BENCH_ALL_ISA_QSORT(uint32_t)
+BENCH_ALL_ISA_QSORT(float)
+BENCH_ALL_ISA_QSORT(uint64_t)
+BENCH_ALL_ISA_QSORT(double)
 #ifdef __FLT16_MAX__
 BENCH_BOTH_QSORT(_Float16)
 #endif
@@ -0,0 +1,63 @@
+// AVX10.1/256 specific routines:
+#include "x86simdsort-static-incl.h"
+#include "avx10-256-qsort.hpp"
+#include "x86simdsort-internal.h"
+
+#define DEFINE_ALL_METHODS(type) \
+    template <> \
+    void qsort(type *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx10_256_qsort(arr, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void qsort_parallel(type *arr, \
+                        size_t arrsize, \
+                        x86simdsort::executor &ex, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        avx10_256_qsort_parallel(arr, arrsize, ex, hasnan, descending); \
+    } \
+    template <> \
+    void qselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx10_256_qselect(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void partial_qsort( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx10_256_partial_qsort(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void qsort_segments(type *arr, \
+                        const size_t *offsets, \
+                        size_t num_segments, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        avx10_256_qsort_segments( \
+                arr, offsets, num_segments, hasnan, descending); \
+    } \
+    template <> \
+    size_t topk_filter(const type *arr, \
+                       size_t arrsize, \
+                       type threshold, \
+                       type *out, \
+                       bool descending) \
+    { \
+        return avx10_256_topk_filter( \
+                arr, arrsize, threshold, out, descending); \
+    }
+
+namespace xss {
+namespace avx10_256 {
+    DEFINE_ALL_METHODS(uint32_t)
+    DEFINE_ALL_METHODS(int32_t)
+    DEFINE_ALL_METHODS(float)
+    DEFINE_ALL_METHODS(uint64_t)
+    DEFINE_ALL_METHODS(int64_t)
+    DEFINE_ALL_METHODS(double)
+} // namespace avx10_256
+} // namespace xss
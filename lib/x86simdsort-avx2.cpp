@@ -10,6 +10,16 @@
         x86simdsortStatic::qsort(arr, arrsize, hasnan, descending); \
     } \
     template <> \
+    void qsort_parallel(type *arr, \
+                        size_t arrsize, \
+                        x86simdsort::executor &ex, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        x86simdsortStatic::qsort_parallel( \
+                arr, arrsize, ex, hasnan, descending); \
+    } \
+    template <> \
     void qselect( \
             type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
     { \
@@ -22,16 +32,87 @@
         x86simdsortStatic::partial_qsort(arr, k, arrsize, hasnan, descending); \
     } \
     template <> \
-    std::vector<size_t> argsort( \
-            type *arr, size_t arrsize, bool hasnan, bool descending) \
+    void qsort_segments(type *arr, \
+                        const size_t *offsets, \
+                        size_t num_segments, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        x86simdsortStatic::qsort_segments( \
+                arr, offsets, num_segments, hasnan, descending); \
+    } \
+    template <> \
+    size_t topk_filter(const type *arr, \
+                       size_t arrsize, \
+                       type threshold, \
+                       type *out, \
+                       bool descending) \
+    { \
+        return x86simdsortStatic::topk_filter( \
+                arr, arrsize, threshold, out, descending); \
+    } \
+    DEFINE_ARG_METHODS(type)
+
+#define DEFINE_ARG_METHODS(type) \
+    template <> \
+    void argsort(type *arr, \
+                 size_t *arg, \
+                 size_t arrsize, \
+                 bool hasnan, \
+                 bool descending) \
+    { \
+        x86simdsortStatic::argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect( \
+            type *arr, size_t *arg, size_t k, size_t arrsize, bool hasnan) \
     { \
-        return x86simdsortStatic::argsort(arr, arrsize, hasnan, descending); \
+        x86simdsortStatic::argselect(arr, arg, k, arrsize, hasnan); \
     } \
     template <> \
-    std::vector<size_t> argselect( \
-            type *arr, size_t k, size_t arrsize, bool hasnan) \
+    void argsort32(type *arr, \
+                   uint32_t *arg, \
+                   size_t arrsize, \
+                   bool hasnan, \
+                   bool descending) \
     { \
-        return x86simdsortStatic::argselect(arr, k, arrsize, hasnan); \
+        x86simdsortStatic::argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect32( \
+            type *arr, uint32_t *arg, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        x86simdsortStatic::argselect(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort_parallel(type *arr, \
+                          size_t *arg, \
+                          size_t arrsize, \
+                          x86simdsort::executor &ex, \
+                          bool hasnan, \
+                          bool descending) \
+    { \
+        x86simdsortStatic::argsort_parallel( \
+                arr, arg, arrsize, ex, hasnan, descending); \
+    } \
+    template <> \
+    void argselect_parallel(type *arr, \
+                            size_t *arg, \
+                            size_t k, \
+                            size_t arrsize, \
+                            x86simdsort::executor &ex, \
+                            bool hasnan) \
+    { \
+        x86simdsortStatic::argselect_parallel( \
+                arr, arg, k, arrsize, ex, hasnan); \
+    }
+
+#define DEFINE_STRIDED_GATHER(type) \
+    template <> \
+    void strided_gather( \
+            const void *base, size_t stride, size_t arrsize, type *out) \
+    { \
+        x86simdsortStatic::strided_gather(base, stride, arrsize, out); \
     }
 
 #define DEFINE_KEYVALUE_METHODS_BASE(type1, type2) \
@@ -74,7 +155,9 @@
     DEFINE_KEYVALUE_METHODS_BASE(type, double) \
     DEFINE_KEYVALUE_METHODS_BASE(type, uint32_t) \
     DEFINE_KEYVALUE_METHODS_BASE(type, int32_t) \
-    DEFINE_KEYVALUE_METHODS_BASE(type, float)
+    DEFINE_KEYVALUE_METHODS_BASE(type, float) \
+    DEFINE_KEYVALUE_METHODS_BASE(type, uint16_t) \
+    DEFINE_KEYVALUE_METHODS_BASE(type, int16_t)
 
 namespace xss {
 namespace avx2 {
@@ -84,11 +167,95 @@ namespace avx2 {
     DEFINE_ALL_METHODS(uint64_t)
     DEFINE_ALL_METHODS(int64_t)
     DEFINE_ALL_METHODS(double)
+    DEFINE_STRIDED_GATHER(uint32_t)
+    DEFINE_STRIDED_GATHER(int32_t)
+    DEFINE_STRIDED_GATHER(float)
+    DEFINE_STRIDED_GATHER(uint64_t)
+    DEFINE_STRIDED_GATHER(int64_t)
+    DEFINE_STRIDED_GATHER(double)
     DEFINE_KEYVALUE_METHODS(uint64_t)
     DEFINE_KEYVALUE_METHODS(int64_t)
     DEFINE_KEYVALUE_METHODS(double)
     DEFINE_KEYVALUE_METHODS(uint32_t)
     DEFINE_KEYVALUE_METHODS(int32_t)
     DEFINE_KEYVALUE_METHODS(float)
+    DEFINE_KEYVALUE_METHODS(uint16_t)
+    DEFINE_KEYVALUE_METHODS(int16_t)
+#ifdef __FLT16_MAX__
+    DEFINE_KEYVALUE_METHODS(_Float16)
+#endif
+    DEFINE_ALL_METHODS(uint16_t)
+    DEFINE_ALL_METHODS(int16_t)
+#ifdef __BFLT16_MAX__
+    template <>
+    void qsort(__bf16 *arr, size_t size, bool hasnan, bool descending)
+    {
+        x86simdsortStatic::qsort(arr, size, hasnan, descending);
+    }
+    template <>
+    void qselect(__bf16 *arr,
+                 size_t k,
+                 size_t arrsize,
+                 bool hasnan,
+                 bool descending)
+    {
+        x86simdsortStatic::qselect(arr, k, arrsize, hasnan, descending);
+    }
+    template <>
+    void partial_qsort(__bf16 *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       bool descending)
+    {
+        x86simdsortStatic::partial_qsort(arr, k, arrsize, hasnan, descending);
+    }
+    DEFINE_ARG_METHODS(__bf16)
+#endif
+#ifdef __FLT16_MAX__
+    template <>
+    void qsort(_Float16 *arr, size_t size, bool hasnan, bool descending)
+    {
+        x86simdsortStatic::qsort(arr, size, hasnan, descending);
+    }
+    template <>
+    void qsort_parallel(_Float16 *arr,
+                        size_t size,
+                        x86simdsort::executor &ex,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_parallel(arr, size, ex, hasnan, descending);
+    }
+    template <>
+    void qselect(_Float16 *arr,
+                 size_t k,
+                 size_t arrsize,
+                 bool hasnan,
+                 bool descending)
+    {
+        x86simdsortStatic::qselect(arr, k, arrsize, hasnan, descending);
+    }
+    template <>
+    void partial_qsort(_Float16 *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       bool descending)
+    {
+        x86simdsortStatic::partial_qsort(arr, k, arrsize, hasnan, descending);
+    }
+    template <>
+    void qsort_segments(_Float16 *arr,
+                        const size_t *offsets,
+                        size_t num_segments,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_segments(
+                arr, offsets, num_segments, hasnan, descending);
+    }
+    DEFINE_ARG_METHODS(_Float16)
+#endif
 } // namespace avx2
 } // namespace xss
\ No newline at end of file
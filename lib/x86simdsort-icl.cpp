@@ -2,6 +2,60 @@
 #include "x86simdsort-static-incl.h"
 #include "x86simdsort-internal.h"
 
+#define DEFINE_ARG_METHODS(type) \
+    template <> \
+    void argsort(type *arr, \
+                 size_t *arg, \
+                 size_t arrsize, \
+                 bool hasnan, \
+                 bool descending) \
+    { \
+        x86simdsortStatic::argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect( \
+            type *arr, size_t *arg, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        x86simdsortStatic::argselect(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort32(type *arr, \
+                   uint32_t *arg, \
+                   size_t arrsize, \
+                   bool hasnan, \
+                   bool descending) \
+    { \
+        x86simdsortStatic::argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect32( \
+            type *arr, uint32_t *arg, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        x86simdsortStatic::argselect(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort_parallel(type *arr, \
+                          size_t *arg, \
+                          size_t arrsize, \
+                          x86simdsort::executor &ex, \
+                          bool hasnan, \
+                          bool descending) \
+    { \
+        x86simdsortStatic::argsort_parallel( \
+                arr, arg, arrsize, ex, hasnan, descending); \
+    } \
+    template <> \
+    void argselect_parallel(type *arr, \
+                            size_t *arg, \
+                            size_t k, \
+                            size_t arrsize, \
+                            x86simdsort::executor &ex, \
+                            bool hasnan) \
+    { \
+        x86simdsortStatic::argselect_parallel( \
+                arr, arg, k, arrsize, ex, hasnan); \
+    }
+
 namespace xss {
 namespace avx512 {
     template <>
@@ -10,6 +64,15 @@ namespace avx512 {
         x86simdsortStatic::qsort(arr, size, hasnan, descending);
     }
     template <>
+    void qsort_parallel(uint16_t *arr,
+                        size_t size,
+                        x86simdsort::executor &ex,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_parallel(arr, size, ex, hasnan, descending);
+    }
+    template <>
     void qselect(uint16_t *arr,
                  size_t k,
                  size_t arrsize,
@@ -28,11 +91,40 @@ namespace avx512 {
         x86simdsortStatic::partial_qsort(arr, k, arrsize, hasnan, descending);
     }
     template <>
+    void qsort_segments(uint16_t *arr,
+                        const size_t *offsets,
+                        size_t num_segments,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_segments(
+                arr, offsets, num_segments, hasnan, descending);
+    }
+    template <>
+    size_t topk_filter(const uint16_t *arr,
+                       size_t arrsize,
+                       uint16_t threshold,
+                       uint16_t *out,
+                       bool descending)
+    {
+        return x86simdsortStatic::topk_filter(
+                arr, arrsize, threshold, out, descending);
+    }
+    template <>
     void qsort(int16_t *arr, size_t size, bool hasnan, bool descending)
     {
         x86simdsortStatic::qsort(arr, size, hasnan, descending);
     }
     template <>
+    void qsort_parallel(int16_t *arr,
+                        size_t size,
+                        x86simdsort::executor &ex,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_parallel(arr, size, ex, hasnan, descending);
+    }
+    template <>
     void qselect(int16_t *arr,
                  size_t k,
                  size_t arrsize,
@@ -50,6 +142,51 @@ namespace avx512 {
     {
         x86simdsortStatic::partial_qsort(arr, k, arrsize, hasnan, descending);
     }
+    template <>
+    void qsort_segments(int16_t *arr,
+                        const size_t *offsets,
+                        size_t num_segments,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_segments(
+                arr, offsets, num_segments, hasnan, descending);
+    }
+    template <>
+    size_t topk_filter(const int16_t *arr,
+                       size_t arrsize,
+                       int16_t threshold,
+                       int16_t *out,
+                       bool descending)
+    {
+        return x86simdsortStatic::topk_filter(
+                arr, arrsize, threshold, out, descending);
+    }
+#ifdef __BFLT16_MAX__
+    template <>
+    void qsort(__bf16 *arr, size_t size, bool hasnan, bool descending)
+    {
+        x86simdsortStatic::qsort(arr, size, hasnan, descending);
+    }
+    template <>
+    void qselect(__bf16 *arr,
+                 size_t k,
+                 size_t arrsize,
+                 bool hasnan,
+                 bool descending)
+    {
+        x86simdsortStatic::qselect(arr, k, arrsize, hasnan, descending);
+    }
+    template <>
+    void partial_qsort(__bf16 *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       bool descending)
+    {
+        x86simdsortStatic::partial_qsort(arr, k, arrsize, hasnan, descending);
+    }
+#endif
 } // namespace avx512
 namespace fp16_icl {
 #ifdef __FLT16_MAX__
@@ -59,6 +196,15 @@ namespace fp16_icl {
         x86simdsortStatic::qsort(arr, size, hasnan, descending);
     }
     template <>
+    void qsort_parallel(_Float16 *arr,
+                        size_t size,
+                        x86simdsort::executor &ex,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_parallel(arr, size, ex, hasnan, descending);
+    }
+    template <>
     void qselect(_Float16 *arr,
                  size_t k,
                  size_t arrsize,
@@ -76,6 +222,27 @@ namespace fp16_icl {
     {
         x86simdsortStatic::partial_qsort(arr, k, arrsize, hasnan, descending);
     }
+    template <>
+    void qsort_segments(_Float16 *arr,
+                        const size_t *offsets,
+                        size_t num_segments,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_segments(
+                arr, offsets, num_segments, hasnan, descending);
+    }
+    template <>
+    size_t topk_filter(const _Float16 *arr,
+                       size_t arrsize,
+                       _Float16 threshold,
+                       _Float16 *out,
+                       bool descending)
+    {
+        return x86simdsortStatic::topk_filter(
+                arr, arrsize, threshold, out, descending);
+    }
+    DEFINE_ARG_METHODS(_Float16)
 #endif
 } // namespace fp16_icl
 } // namespace xss
@@ -11,6 +11,12 @@
                                size_t arrsize, \
                                bool hasnan = false, \
                                bool descending = false); \
+    template <typename T> \
+    XSS_HIDE_SYMBOL void qsort_parallel(T *arr, \
+                                        size_t arrsize, \
+                                        x86simdsort::executor &ex, \
+                                        bool hasnan = false, \
+                                        bool descending = false); \
     template <typename T1, typename T2> \
     XSS_HIDE_SYMBOL void keyvalue_qsort(T1 *key, \
                                         T2 *val, \
@@ -36,6 +42,21 @@
                                        size_t arrsize, \
                                        bool hasnan = false, \
                                        bool descending = false); \
+    template <typename T> \
+    XSS_HIDE_SYMBOL void qsort_segments(T *arr, \
+                                        const size_t *offsets, \
+                                        size_t num_segments, \
+                                        bool hasnan = false, \
+                                        bool descending = false); \
+    template <typename T> \
+    XSS_HIDE_SYMBOL size_t topk_filter(const T *arr, \
+                                       size_t arrsize, \
+                                       T threshold, \
+                                       T *out, \
+                                       bool descending = false); \
+    template <typename T> \
+    XSS_HIDE_SYMBOL void strided_gather( \
+            const void *base, size_t stride, size_t arrsize, T *out); \
     template <typename T1, typename T2> \
     XSS_HIDE_SYMBOL void keyvalue_partial_sort(T1 *key, \
                                                T2 *val, \
@@ -44,17 +65,49 @@
                                                bool hasnan = false, \
                                                bool descending = false); \
     template <typename T> \
-    XSS_HIDE_SYMBOL std::vector<size_t> argsort(T *arr, \
-                                                size_t arrsize, \
-                                                bool hasnan = false, \
-                                                bool descending = false); \
+    XSS_HIDE_SYMBOL void argsort(T *arr, \
+                                 size_t *arg, \
+                                 size_t arrsize, \
+                                 bool hasnan = false, \
+                                 bool descending = false); \
+    template <typename T> \
+    XSS_HIDE_SYMBOL void argselect(T *arr, \
+                                   size_t *arg, \
+                                   size_t k, \
+                                   size_t arrsize, \
+                                   bool hasnan = false); \
+    template <typename T> \
+    XSS_HIDE_SYMBOL void argsort32(T *arr, \
+                                   uint32_t *arg, \
+                                   size_t arrsize, \
+                                   bool hasnan = false, \
+                                   bool descending = false); \
+    template <typename T> \
+    XSS_HIDE_SYMBOL void argselect32(T *arr, \
+                                     uint32_t *arg, \
+                                     size_t k, \
+                                     size_t arrsize, \
+                                     bool hasnan = false); \
+    template <typename T> \
+    XSS_HIDE_SYMBOL void argsort_parallel(T *arr, \
+                                          size_t *arg, \
+                                          size_t arrsize, \
+                                          x86simdsort::executor &ex, \
+                                          bool hasnan = false, \
+                                          bool descending = false); \
     template <typename T> \
-    XSS_HIDE_SYMBOL std::vector<size_t> \
-    argselect(T *arr, size_t k, size_t arrsize, bool hasnan = false); \
+    XSS_HIDE_SYMBOL void argselect_parallel(T *arr, \
+                                            size_t *arg, \
+                                            size_t k, \
+                                            size_t arrsize, \
+                                            x86simdsort::executor &ex, \
+                                            bool hasnan = false); \
     }
 
 namespace xss {
 DECLAREALLFUNCS(avx512)
+DECLAREALLFUNCS(zen4)
+DECLAREALLFUNCS(avx10_256)
 DECLAREALLFUNCS(avx2)
 DECLAREALLFUNCS(scalar)
 DECLAREALLFUNCS(fp16_spr)
@@ -52,6 +52,17 @@ namespace scalar {
                   xss::utils::get_cmp_func<T>(hasnan, reversed));
     }
 
+    template <typename T>
+    void qsort_parallel(T *arr,
+                        size_t arrsize,
+                        x86simdsort::executor &ex,
+                        bool hasnan,
+                        bool reversed)
+    {
+        UNUSED(ex);
+        qsort(arr, arrsize, hasnan, reversed);
+    }
+
     template <typename T>
     void qselect(T *arr, size_t k, size_t arrsize, bool hasnan, bool reversed)
     {
@@ -70,40 +81,108 @@ namespace scalar {
                           xss::utils::get_cmp_func<T>(hasnan, reversed));
     }
     template <typename T>
-    std::vector<size_t>
-    argsort(T *arr, size_t arrsize, bool hasnan, bool reversed)
+    void qsort_segments(T *arr,
+                        const size_t *offsets,
+                        size_t num_segments,
+                        bool hasnan,
+                        bool reversed)
+    {
+        for (size_t ii = 0; ii < num_segments; ++ii) {
+            qsort(arr + offsets[ii],
+                  offsets[ii + 1] - offsets[ii],
+                  hasnan,
+                  reversed);
+        }
+    }
+    template <typename T>
+    size_t topk_filter(
+            const T *arr, size_t arrsize, T threshold, T *out, bool reversed)
+    {
+        auto cmp = xss::utils::get_cmp_func<T>(false, reversed);
+        size_t count = 0;
+        for (size_t ii = 0; ii < arrsize; ++ii) {
+            if (cmp(arr[ii], threshold)) { out[count++] = arr[ii]; }
+        }
+        return count;
+    }
+    template <typename T>
+    void
+    strided_gather(const void *base, size_t stride, size_t arrsize, T *out)
+    {
+        const char *src = (const char *)base;
+        for (size_t ii = 0; ii < arrsize; ++ii) {
+            std::memcpy(out + ii, src + ii * stride, sizeof(T));
+        }
+    }
+    template <typename T>
+    void argsort(T *arr, size_t *arg, size_t arrsize, bool hasnan, bool reversed)
     {
         UNUSED(hasnan);
-        std::vector<size_t> arg(arrsize);
-        std::iota(arg.begin(), arg.end(), 0);
         if (reversed) {
-            std::sort(arg.begin(),
-                      arg.end(),
-                      compare_arg<T, std::greater<T>>(arr));
+            std::sort(arg, arg + arrsize, compare_arg<T, std::greater<T>>(arr));
         }
         else {
-            std::sort(
-                    arg.begin(), arg.end(), compare_arg<T, std::less<T>>(arr));
+            std::sort(arg, arg + arrsize, compare_arg<T, std::less<T>>(arr));
         }
-        return arg;
     }
     template <typename T>
-    std::vector<size_t> argselect(T *arr, size_t k, size_t arrsize, bool hasnan)
+    void argselect(T *arr, size_t *arg, size_t k, size_t arrsize, bool hasnan)
     {
         UNUSED(hasnan);
-        std::vector<size_t> arg(arrsize);
-        std::iota(arg.begin(), arg.end(), 0);
-        std::nth_element(arg.begin(),
-                         arg.begin() + k,
-                         arg.end(),
-                         compare_arg<T, std::less<T>>(arr));
-        return arg;
+        std::nth_element(
+                arg, arg + k, arg + arrsize, compare_arg<T, std::less<T>>(arr));
+    }
+    template <typename T>
+    void argsort32(
+            T *arr, uint32_t *arg, size_t arrsize, bool hasnan, bool reversed)
+    {
+        UNUSED(hasnan);
+        if (reversed) {
+            std::sort(arg, arg + arrsize, compare_arg<T, std::greater<T>>(arr));
+        }
+        else {
+            std::sort(arg, arg + arrsize, compare_arg<T, std::less<T>>(arr));
+        }
+    }
+    template <typename T>
+    void argselect32(
+            T *arr, uint32_t *arg, size_t k, size_t arrsize, bool hasnan)
+    {
+        UNUSED(hasnan);
+        std::nth_element(
+                arg, arg + k, arg + arrsize, compare_arg<T, std::less<T>>(arr));
+    }
+    template <typename T>
+    void argsort_parallel(T *arr,
+                          size_t *arg,
+                          size_t arrsize,
+                          x86simdsort::executor &ex,
+                          bool hasnan,
+                          bool reversed)
+    {
+        UNUSED(ex);
+        std::iota(arg, arg + arrsize, 0);
+        argsort(arr, arg, arrsize, hasnan, reversed);
+    }
+    template <typename T>
+    void argselect_parallel(T *arr,
+                            size_t *arg,
+                            size_t k,
+                            size_t arrsize,
+                            x86simdsort::executor &ex,
+                            bool hasnan)
+    {
+        UNUSED(ex);
+        std::iota(arg, arg + arrsize, 0);
+        argselect(arr, arg, k, arrsize, hasnan);
     }
     template <typename T1, typename T2>
     void keyvalue_qsort(
             T1 *key, T2 *val, size_t arrsize, bool hasnan, bool descending)
     {
-        std::vector<size_t> arg = argsort(key, arrsize, hasnan, descending);
+        std::vector<size_t> arg(arrsize);
+        std::iota(arg.begin(), arg.end(), 0);
+        argsort(key, arg.data(), arrsize, hasnan, descending);
         utils::apply_permutation_in_place(key, arg);
         utils::apply_permutation_in_place(val, arg);
     }
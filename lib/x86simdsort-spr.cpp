@@ -2,6 +2,60 @@
 #include "x86simdsort-static-incl.h"
 #include "x86simdsort-internal.h"
 
+#define DEFINE_ARG_METHODS(type) \
+    template <> \
+    void argsort(type *arr, \
+                 size_t *arg, \
+                 size_t arrsize, \
+                 bool hasnan, \
+                 bool descending) \
+    { \
+        x86simdsortStatic::argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect( \
+            type *arr, size_t *arg, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        x86simdsortStatic::argselect(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort32(type *arr, \
+                   uint32_t *arg, \
+                   size_t arrsize, \
+                   bool hasnan, \
+                   bool descending) \
+    { \
+        x86simdsortStatic::argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect32( \
+            type *arr, uint32_t *arg, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        x86simdsortStatic::argselect(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort_parallel(type *arr, \
+                          size_t *arg, \
+                          size_t arrsize, \
+                          x86simdsort::executor &ex, \
+                          bool hasnan, \
+                          bool descending) \
+    { \
+        x86simdsortStatic::argsort_parallel( \
+                arr, arg, arrsize, ex, hasnan, descending); \
+    } \
+    template <> \
+    void argselect_parallel(type *arr, \
+                            size_t *arg, \
+                            size_t k, \
+                            size_t arrsize, \
+                            x86simdsort::executor &ex, \
+                            bool hasnan) \
+    { \
+        x86simdsortStatic::argselect_parallel( \
+                arr, arg, k, arrsize, ex, hasnan); \
+    }
+
 namespace xss {
 namespace fp16_spr {
     template <>
@@ -10,6 +64,15 @@ namespace fp16_spr {
         x86simdsortStatic::qsort(arr, size, hasnan, descending);
     }
     template <>
+    void qsort_parallel(_Float16 *arr,
+                        size_t size,
+                        x86simdsort::executor &ex,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_parallel(arr, size, ex, hasnan, descending);
+    }
+    template <>
     void qselect(_Float16 *arr,
                  size_t k,
                  size_t arrsize,
@@ -27,5 +90,26 @@ namespace fp16_spr {
     {
         x86simdsortStatic::partial_qsort(arr, k, arrsize, hasnan, descending);
     }
+    template <>
+    void qsort_segments(_Float16 *arr,
+                        const size_t *offsets,
+                        size_t num_segments,
+                        bool hasnan,
+                        bool descending)
+    {
+        x86simdsortStatic::qsort_segments(
+                arr, offsets, num_segments, hasnan, descending);
+    }
+    template <>
+    size_t topk_filter(const _Float16 *arr,
+                       size_t arrsize,
+                       _Float16 threshold,
+                       _Float16 *out,
+                       bool descending)
+    {
+        return x86simdsortStatic::topk_filter(
+                arr, arrsize, threshold, out, descending);
+    }
+    DEFINE_ARG_METHODS(_Float16)
 } // namespace fp16_spr
 } // namespace xss
@@ -0,0 +1,63 @@
+// Zen4 and Zen5 specific routines:
+#include "x86simdsort-static-incl.h"
+#include "avx512-zen4-qsort.hpp"
+#include "x86simdsort-internal.h"
+
+#define DEFINE_ALL_METHODS(type) \
+    template <> \
+    void qsort(type *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        zen4_qsort(arr, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void qsort_parallel(type *arr, \
+                        size_t arrsize, \
+                        x86simdsort::executor &ex, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        zen4_qsort_parallel(arr, arrsize, ex, hasnan, descending); \
+    } \
+    template <> \
+    void qselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        zen4_qselect(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void partial_qsort( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        zen4_partial_qsort(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void qsort_segments(type *arr, \
+                        const size_t *offsets, \
+                        size_t num_segments, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        zen4_qsort_segments(arr, offsets, num_segments, hasnan, descending); \
+    } \
+    template <> \
+    size_t topk_filter(const type *arr, \
+                       size_t arrsize, \
+                       type threshold, \
+                       type *out, \
+                       bool descending) \
+    { \
+        return zen4_topk_filter(arr, arrsize, threshold, out, descending); \
+    }
+
+namespace xss {
+namespace zen4 {
+    DEFINE_ALL_METHODS(uint16_t)
+    DEFINE_ALL_METHODS(int16_t)
+    DEFINE_ALL_METHODS(uint32_t)
+    DEFINE_ALL_METHODS(int32_t)
+    DEFINE_ALL_METHODS(float)
+    DEFINE_ALL_METHODS(uint64_t)
+    DEFINE_ALL_METHODS(int64_t)
+    DEFINE_ALL_METHODS(double)
+} // namespace zen4
+} // namespace xss
@@ -1,47 +1,135 @@
 #include "x86simdsort.h"
 #include "x86simdsort-internal.h"
 #include "x86simdsort-scalar.h"
+#include "xss-thread-pool.hpp"
 #include <algorithm>
+#include <cpuid.h>
 #include <iostream>
+#include <mutex>
 #include <string>
 
-static int check_cpu_feature_support(std::string_view cpufeature)
+/* CPU features the dispatcher cares about, detected once per process */
+struct cpu_features {
+    bool avx512_zen4;
+    bool avx512_spr;
+    bool avx512_icl;
+    bool avx512_skx;
+    bool avx10_256;
+    bool avx2;
+};
+
+/* AVX10.1/256: CPUID.(7,1):EDX[19] announces AVX10, leaf 0x24 reports its
+ * version and vector widths, and the OS has to save the opmask and upper
+ * register state */
+static bool cpu_supports_avx10_256()
 {
-    const char *disable_avx512 = std::getenv("XSS_DISABLE_AVX512");
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE))
+        return false;
+    if (!__get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)
+        || !(edx & (1u << 19)))
+        return false;
+    if (!__get_cpuid_count(0x24, 0, &eax, &ebx, &ecx, &edx)
+        || (ebx & 0xff) < 1 || !(ebx & (1u << 17)))
+        return false;
+    unsigned int xcr0, xcr0_hi;
+    __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0_hi) : "c"(0));
+    return (xcr0 & 0xe6) == 0xe6;
+}
 
-    if ((cpufeature == "avx512_spr") && (!disable_avx512))
+static cpu_features detect_cpu_features()
+{
+    __builtin_cpu_init();
+    const bool disable_avx512 = std::getenv("XSS_DISABLE_AVX512") != nullptr;
+    cpu_features features;
 #if defined(__FLT16_MAX__) && !defined(__INTEL_LLVM_COMPILER) \
         && (!defined(__clang_major__) || __clang_major__ >= 18)
-        return __builtin_cpu_supports("avx512f")
-                && __builtin_cpu_supports("avx512fp16")
-                && __builtin_cpu_supports("avx512vbmi2");
+    features.avx512_spr = !disable_avx512 && __builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512fp16")
+            && __builtin_cpu_supports("avx512vbmi2");
 #else
-        return 0;
+    features.avx512_spr = false;
 #endif
-    else if ((cpufeature == "avx512_icl") && (!disable_avx512))
-        return __builtin_cpu_supports("avx512f")
-                && __builtin_cpu_supports("avx512vbmi2")
-                && __builtin_cpu_supports("avx512bw")
-                && __builtin_cpu_supports("avx512vl");
-    else if ((cpufeature == "avx512_skx") && (!disable_avx512))
-        return __builtin_cpu_supports("avx512f")
-                && __builtin_cpu_supports("avx512dq")
-                && __builtin_cpu_supports("avx512vl");
+    features.avx512_icl = !disable_avx512 && __builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512vbmi2")
+            && __builtin_cpu_supports("avx512bw")
+            && __builtin_cpu_supports("avx512vl");
+    features.avx512_skx = !disable_avx512 && __builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512dq")
+            && __builtin_cpu_supports("avx512vl");
+    /* every AMD CPU with AVX-512 so far (Zen4, Zen5) microcodes vpcompress
+     * to memory */
+    features.avx512_zen4 = features.avx512_icl && features.avx512_skx
+            && __builtin_cpu_is("amd");
+    /* the ymm kernels also run on every CPU with the SKX feature set */
+    features.avx10_256 = !disable_avx512
+            && (features.avx512_skx || cpu_supports_avx10_256());
+    features.avx2 = __builtin_cpu_supports("avx2");
+    return features;
+}
+
+static int check_cpu_feature_support(const cpu_features &features,
+                                     std::string_view cpufeature)
+{
+    if (cpufeature == "avx512_zen4")
+        return features.avx512_zen4;
+    else if (cpufeature == "avx512_spr")
+        return features.avx512_spr;
+    else if (cpufeature == "avx512_icl")
+        return features.avx512_icl;
+    else if (cpufeature == "avx512_skx")
+        return features.avx512_skx;
+    else if (cpufeature == "avx10_256")
+        return features.avx10_256;
     else if (cpufeature == "avx2")
-        return __builtin_cpu_supports("avx2");
+        return features.avx2;
 
     return 0;
 }
 
 std::string_view static find_preferred_cpu(
+        const cpu_features &features,
         std::initializer_list<std::string_view> cpulist)
 {
     for (auto cpu : cpulist) {
-        if (check_cpu_feature_support(cpu)) return cpu;
+        if (check_cpu_feature_support(features, cpu)) return cpu;
     }
     return "scalar";
 }
 
+/* ISAs a dispatch can be capped at, from most to least preferred */
+static constexpr std::string_view isa_order[] = {"avx512_zen4",
+                                                 "avx512_spr",
+                                                 "avx512_icl",
+                                                 "avx512_skx",
+                                                 "avx10_256",
+                                                 "avx2",
+                                                 "scalar"};
+
+static bool is_known_isa(std::string_view isa)
+{
+    return std::find(std::begin(isa_order), std::end(isa_order), isa)
+            != std::end(isa_order);
+}
+
+/* masks off every ISA that ranks above preferred_isa ("" keeps all of them) */
+static cpu_features cap_cpu_features(cpu_features features,
+                                     std::string_view preferred_isa)
+{
+    if (preferred_isa.empty()) return features;
+    bool *supported[] = {&features.avx512_zen4,
+                         &features.avx512_spr,
+                         &features.avx512_icl,
+                         &features.avx512_skx,
+                         &features.avx10_256,
+                         &features.avx2};
+    for (size_t ii = 0; ii < std::size(supported); ++ii) {
+        if (isa_order[ii] == preferred_isa) break;
+        *supported[ii] = false;
+    }
+    return features;
+}
+
 constexpr bool
 dispatch_requested(std::string_view cpurequested,
                    std::initializer_list<std::string_view> cpulist)
@@ -57,17 +145,98 @@ namespace x86simdsort {
 #define CAT_(a, b) a##b
 #define CAT(a, b) CAT_(a, b)
 
+static void resolve_dispatch_table();
+
+/* Every function pointer of the dispatch table starts out pointing at
+ * lazy_dispatch<...>::call, which resolves the whole table on first use and
+ * then forwards to the routine the pointer was resolved to. Later calls go
+ * straight to the resolved routine. */
+template <typename F, F &ptr>
+struct lazy_dispatch;
+
+template <typename R, typename... Args, R (*&ptr)(Args...)>
+struct lazy_dispatch<R (*)(Args...), ptr> {
+    static R call(Args... args)
+    {
+        resolve_dispatch_table();
+        return (*ptr)(args...);
+    }
+};
+
+#define XSS_LAZY(ptr) &lazy_dispatch<decltype(ptr), ptr>::call
+
 #define DECLARE_INTERNAL_qsort(TYPE) \
-    static void (*internal_qsort##TYPE)(TYPE *, size_t, bool, bool) = NULL; \
+    static void (*internal_qsort##TYPE)(TYPE *, size_t, bool, bool) \
+            = XSS_LAZY(internal_qsort##TYPE); \
     template <> \
     void qsort(TYPE *arr, size_t arrsize, bool hasnan, bool descending) \
     { \
         (*internal_qsort##TYPE)(arr, arrsize, hasnan, descending); \
     }
 
+/* executor backed by the library's own work-stealing thread pool */
+class pool_executor : public executor {
+public:
+    explicit pool_executor(int num_threads) : pool(num_threads) {}
+    void submit(std::function<void()> job) override
+    {
+        pool.submit(std::move(job));
+    }
+
+private:
+    xss::thread_pool pool;
+};
+
+/* shared by all parallel calls that do not ask for a thread count, its
+ * workers are only started by the first parallel sort */
+static executor &default_executor()
+{
+    static pool_executor ex(0);
+    return ex;
+}
+
+/* runs func(executor &) on the shared pool, or on a pool of num_threads
+ * threads that lives for the duration of the call */
+template <typename Func>
+static void with_executor(int num_threads, Func func)
+{
+    if (num_threads <= 0) { func(default_executor()); }
+    else {
+        pool_executor ex(num_threads);
+        func(ex);
+    }
+}
+
+#define DECLARE_INTERNAL_qsort_parallel(TYPE) \
+    static void (*internal_qsort_parallel##TYPE)( \
+            TYPE *, size_t, executor &, bool, bool) \
+            = XSS_LAZY(internal_qsort_parallel##TYPE); \
+    template <> \
+    void qsort_parallel(TYPE *arr, \
+                        size_t arrsize, \
+                        executor &ex, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        (*internal_qsort_parallel##TYPE)( \
+                arr, arrsize, ex, hasnan, descending); \
+    } \
+    template <> \
+    void qsort_parallel(TYPE *arr, \
+                        size_t arrsize, \
+                        int num_threads, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        with_executor(num_threads, [&](executor &ex) { \
+            (*internal_qsort_parallel##TYPE)( \
+                    arr, arrsize, ex, hasnan, descending); \
+        }); \
+    }
+
 #define DECLARE_INTERNAL_qselect(TYPE) \
     static void (*internal_qselect##TYPE)(TYPE *, size_t, size_t, bool, bool) \
-            = NULL; \
+            = XSS_LAZY(internal_qselect##TYPE); \
     template <> \
     void qselect( \
             TYPE *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
@@ -78,7 +247,7 @@ namespace x86simdsort {
 #define DECLARE_INTERNAL_partial_qsort(TYPE) \
     static void (*internal_partial_qsort##TYPE)( \
             TYPE *, size_t, size_t, bool, bool) \
-            = NULL; \
+            = XSS_LAZY(internal_partial_qsort##TYPE); \
     template <> \
     void partial_qsort( \
             TYPE *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
@@ -86,26 +255,215 @@ namespace x86simdsort {
         (*internal_partial_qsort##TYPE)(arr, k, arrsize, hasnan, descending); \
     }
 
+#define DECLARE_INTERNAL_qsort_segments(TYPE) \
+    static void (*internal_qsort_segments##TYPE)( \
+            TYPE *, const size_t *, size_t, bool, bool) \
+            = XSS_LAZY(internal_qsort_segments##TYPE); \
+    template <> \
+    void qsort_segments(TYPE *arr, \
+                        const size_t *offsets, \
+                        size_t num_segments, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        (*internal_qsort_segments##TYPE)( \
+                arr, offsets, num_segments, hasnan, descending); \
+    }
+
+#define DECLARE_INTERNAL_topk_filter(TYPE) \
+    static size_t (*internal_topk_filter##TYPE)( \
+            const TYPE *, size_t, TYPE, TYPE *, bool) \
+            = XSS_LAZY(internal_topk_filter##TYPE); \
+    template <> \
+    size_t topk_filter(const TYPE *arr, \
+                       size_t arrsize, \
+                       TYPE threshold, \
+                       TYPE *out, \
+                       bool descending) \
+    { \
+        return (*internal_topk_filter##TYPE)( \
+                arr, arrsize, threshold, out, descending); \
+    }
+
+#define DECLARE_INTERNAL_strided_gather(TYPE) \
+    static void (*internal_strided_gather##TYPE)( \
+            const void *, size_t, size_t, TYPE *) \
+            = XSS_LAZY(internal_strided_gather##TYPE); \
+    template <> \
+    void strided_gather( \
+            const void *base, size_t stride, size_t arrsize, TYPE *out) \
+    { \
+        (*internal_strided_gather##TYPE)(base, stride, arrsize, out); \
+    }
+
+/* the internal arg methods expect arg to hold 0 ... arrsize-1 on entry */
 #define DECLARE_INTERNAL_argsort(TYPE) \
-    static std::vector<size_t> (*internal_argsort##TYPE)( \
-            TYPE *, size_t, bool, bool) \
-            = NULL; \
+    static void (*internal_argsort##TYPE)( \
+            TYPE *, size_t *, size_t, bool, bool) \
+            = XSS_LAZY(internal_argsort##TYPE); \
+    template <> \
+    void argsort(TYPE *arr, \
+                 size_t *arg, \
+                 size_t arrsize, \
+                 bool hasnan, \
+                 bool descending) \
+    { \
+        std::iota(arg, arg + arrsize, 0); \
+        (*internal_argsort##TYPE)(arr, arg, arrsize, hasnan, descending); \
+    } \
     template <> \
     std::vector<size_t> argsort( \
             TYPE *arr, size_t arrsize, bool hasnan, bool descending) \
     { \
-        return (*internal_argsort##TYPE)(arr, arrsize, hasnan, descending); \
+        std::vector<size_t> indices(arrsize); \
+        argsort(arr, indices.data(), arrsize, hasnan, descending); \
+        return indices; \
     }
 
 #define DECLARE_INTERNAL_argselect(TYPE) \
-    static std::vector<size_t> (*internal_argselect##TYPE)( \
-            TYPE *, size_t, size_t, bool) \
-            = NULL; \
+    static void (*internal_argselect##TYPE)( \
+            TYPE *, size_t *, size_t, size_t, bool) \
+            = XSS_LAZY(internal_argselect##TYPE); \
+    template <> \
+    void argselect( \
+            TYPE *arr, size_t *arg, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        std::iota(arg, arg + arrsize, 0); \
+        (*internal_argselect##TYPE)(arr, arg, k, arrsize, hasnan); \
+    } \
     template <> \
     std::vector<size_t> argselect( \
             TYPE *arr, size_t k, size_t arrsize, bool hasnan) \
     { \
-        return (*internal_argselect##TYPE)(arr, k, arrsize, hasnan); \
+        std::vector<size_t> indices(arrsize); \
+        argselect(arr, indices.data(), k, arrsize, hasnan); \
+        return indices; \
+    }
+
+#define DECLARE_INTERNAL_argsort32(TYPE) \
+    static void (*internal_argsort32##TYPE)( \
+            TYPE *, uint32_t *, size_t, bool, bool) \
+            = XSS_LAZY(internal_argsort32##TYPE); \
+    template <> \
+    void argsort(TYPE *arr, \
+                 uint32_t *arg, \
+                 size_t arrsize, \
+                 bool hasnan, \
+                 bool descending) \
+    { \
+        std::iota(arg, arg + arrsize, 0); \
+        (*internal_argsort32##TYPE)(arr, arg, arrsize, hasnan, descending); \
+    }
+
+#define DECLARE_INTERNAL_argselect32(TYPE) \
+    static void (*internal_argselect32##TYPE)( \
+            TYPE *, uint32_t *, size_t, size_t, bool) \
+            = XSS_LAZY(internal_argselect32##TYPE); \
+    template <> \
+    void argselect( \
+            TYPE *arr, uint32_t *arg, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        std::iota(arg, arg + arrsize, 0); \
+        (*internal_argselect32##TYPE)(arr, arg, k, arrsize, hasnan); \
+    }
+
+#define DECLARE_INTERNAL_argsort_parallel(TYPE) \
+    static void (*internal_argsort_parallel##TYPE)( \
+            TYPE *, size_t *, size_t, executor &, bool, bool) \
+            = XSS_LAZY(internal_argsort_parallel##TYPE); \
+    template <> \
+    void argsort_parallel(TYPE *arr, \
+                          size_t *arg, \
+                          size_t arrsize, \
+                          executor &ex, \
+                          bool hasnan, \
+                          bool descending) \
+    { \
+        (*internal_argsort_parallel##TYPE)( \
+                arr, arg, arrsize, ex, hasnan, descending); \
+    } \
+    template <> \
+    void argsort_parallel(TYPE *arr, \
+                          size_t *arg, \
+                          size_t arrsize, \
+                          int num_threads, \
+                          bool hasnan, \
+                          bool descending) \
+    { \
+        with_executor(num_threads, [&](executor &ex) { \
+            (*internal_argsort_parallel##TYPE)( \
+                    arr, arg, arrsize, ex, hasnan, descending); \
+        }); \
+    } \
+    template <> \
+    std::vector<size_t> argsort_parallel(TYPE *arr, \
+                                         size_t arrsize, \
+                                         executor &ex, \
+                                         bool hasnan, \
+                                         bool descending) \
+    { \
+        std::vector<size_t> indices(arrsize); \
+        argsort_parallel( \
+                arr, indices.data(), arrsize, ex, hasnan, descending); \
+        return indices; \
+    } \
+    template <> \
+    std::vector<size_t> argsort_parallel(TYPE *arr, \
+                                         size_t arrsize, \
+                                         int num_threads, \
+                                         bool hasnan, \
+                                         bool descending) \
+    { \
+        std::vector<size_t> indices(arrsize); \
+        argsort_parallel( \
+                arr, indices.data(), arrsize, num_threads, hasnan, descending); \
+        return indices; \
+    }
+
+#define DECLARE_INTERNAL_argselect_parallel(TYPE) \
+    static void (*internal_argselect_parallel##TYPE)( \
+            TYPE *, size_t *, size_t, size_t, executor &, bool) \
+            = XSS_LAZY(internal_argselect_parallel##TYPE); \
+    template <> \
+    void argselect_parallel(TYPE *arr, \
+                            size_t *arg, \
+                            size_t k, \
+                            size_t arrsize, \
+                            executor &ex, \
+                            bool hasnan) \
+    { \
+        (*internal_argselect_parallel##TYPE)( \
+                arr, arg, k, arrsize, ex, hasnan); \
+    } \
+    template <> \
+    void argselect_parallel(TYPE *arr, \
+                            size_t *arg, \
+                            size_t k, \
+                            size_t arrsize, \
+                            int num_threads, \
+                            bool hasnan) \
+    { \
+        with_executor(num_threads, [&](executor &ex) { \
+            (*internal_argselect_parallel##TYPE)( \
+                    arr, arg, k, arrsize, ex, hasnan); \
+        }); \
+    } \
+    template <> \
+    std::vector<size_t> argselect_parallel( \
+            TYPE *arr, size_t k, size_t arrsize, executor &ex, bool hasnan) \
+    { \
+        std::vector<size_t> indices(arrsize); \
+        argselect_parallel(arr, indices.data(), k, arrsize, ex, hasnan); \
+        return indices; \
+    } \
+    template <> \
+    std::vector<size_t> argselect_parallel( \
+            TYPE *arr, size_t k, size_t arrsize, int num_threads, bool hasnan) \
+    { \
+        std::vector<size_t> indices(arrsize); \
+        argselect_parallel( \
+                arr, indices.data(), k, arrsize, num_threads, hasnan); \
+        return indices; \
     }
 
 /* simple constexpr function as a way around having #ifdef __FLT16_MAX__ block
@@ -119,14 +477,25 @@ constexpr bool IS_TYPE_FLOAT16()
     return false;
 }
 
-/* runtime dispatch mechanism */
+/* runtime dispatch mechanism: DISPATCH declares the function pointer of one
+ * routine together with the function that resolves it and the name of the ISA
+ * it resolved to */
 #define DISPATCH(func, TYPE, ISA) \
-    DECLARE_INTERNAL_##func(TYPE) static __attribute__((constructor)) void \
-    CAT(CAT(resolve_, func), TYPE)(void) \
+    DECLARE_INTERNAL_##func(TYPE) static std::string_view CAT( \
+            CAT(isa_, func), TYPE) \
+            = "scalar"; \
+    static void CAT(CAT(resolve_, func), TYPE)(const cpu_features &features) \
     { \
         CAT(CAT(internal_, func), TYPE) = &xss::scalar::func<TYPE>; \
-        __builtin_cpu_init(); \
-        std::string_view preferred_cpu = find_preferred_cpu(ISA); \
+        CAT(CAT(isa_, func), TYPE) = "scalar"; \
+        std::string_view preferred_cpu = find_preferred_cpu(features, ISA); \
+        if constexpr (dispatch_requested("avx512_zen4", ISA)) { \
+            if (preferred_cpu == "avx512_zen4") { \
+                CAT(CAT(internal_, func), TYPE) = &xss::zen4::func<TYPE>; \
+                CAT(CAT(isa_, func), TYPE) = preferred_cpu; \
+                return; \
+            } \
+        } \
         if constexpr (dispatch_requested("avx512", ISA)) { \
             if (preferred_cpu.find("avx512") != std::string_view::npos) { \
                 if constexpr (IS_TYPE_FLOAT16<TYPE>()) { \
@@ -134,86 +503,231 @@ constexpr bool IS_TYPE_FLOAT16()
                         != std::string_view::npos) { \
                         CAT(CAT(internal_, func), TYPE) \
                                 = &xss::fp16_spr::func<TYPE>; \
+                        CAT(CAT(isa_, func), TYPE) = preferred_cpu; \
                         return; \
                     } \
                     if (preferred_cpu.find("avx512_icl") \
                         != std::string_view::npos) { \
                         CAT(CAT(internal_, func), TYPE) \
                                 = &xss::fp16_icl::func<TYPE>; \
+                        CAT(CAT(isa_, func), TYPE) = preferred_cpu; \
                         return; \
                     } \
                 } \
                 else { \
                     CAT(CAT(internal_, func), TYPE) \
                             = &xss::avx512::func<TYPE>; \
+                    CAT(CAT(isa_, func), TYPE) = preferred_cpu; \
                 } \
                 return; \
             } \
         } \
+        if constexpr (dispatch_requested("avx10_256", ISA)) { \
+            if (preferred_cpu == "avx10_256") { \
+                CAT(CAT(internal_, func), TYPE) = &xss::avx10_256::func<TYPE>; \
+                CAT(CAT(isa_, func), TYPE) = preferred_cpu; \
+                return; \
+            } \
+        } \
         if constexpr (dispatch_requested("avx2", ISA)) { \
             if (preferred_cpu.find("avx2") != std::string_view::npos) { \
                 CAT(CAT(internal_, func), TYPE) = &xss::avx2::func<TYPE>; \
+                CAT(CAT(isa_, func), TYPE) = preferred_cpu; \
                 return; \
             } \
         } \
     }
 
+#define RESOLVE_DISPATCH(func, TYPE, ISA) \
+    CAT(CAT(resolve_, func), TYPE)(features);
+
+#define LIST_DISPATCH(func, TYPE, ISA) \
+    table.push_back({#func, #TYPE, std::string(CAT(CAT(isa_, func), TYPE))});
+
 #define ISA_LIST(...) \
     std::initializer_list<std::string_view> \
     { \
         __VA_ARGS__ \
     }
 
+#define DISPATCH_ALL(X, func, ISA_16BIT, ISA_32BIT, ISA_64BIT) \
+    X(func, uint16_t, ISA_16BIT) \
+    X(func, int16_t, ISA_16BIT) \
+    X(func, float, ISA_32BIT) \
+    X(func, int32_t, ISA_32BIT) \
+    X(func, uint32_t, ISA_32BIT) \
+    X(func, int64_t, ISA_64BIT) \
+    X(func, uint64_t, ISA_64BIT) \
+    X(func, double, ISA_64BIT)
+
 #ifdef __FLT16_MAX__
-DISPATCH(qsort, _Float16, ISA_LIST("avx512_spr", "avx512_icl"))
-DISPATCH(qselect, _Float16, ISA_LIST("avx512_spr", "avx512_icl"))
-DISPATCH(partial_qsort, _Float16, ISA_LIST("avx512_spr", "avx512_icl"))
-DISPATCH(argsort, _Float16, ISA_LIST("none"))
-DISPATCH(argselect, _Float16, ISA_LIST("none"))
+#define DISPATCH_FLOAT16(X) \
+    X(qsort, _Float16, ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(qsort_parallel, \
+      _Float16, \
+      ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(qselect, _Float16, ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(partial_qsort, \
+      _Float16, \
+      ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(qsort_segments, \
+      _Float16, \
+      ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(topk_filter, _Float16, ISA_LIST("avx512_spr", "avx512_icl")) \
+    X(argsort, _Float16, ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(argselect, _Float16, ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(argsort32, _Float16, ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(argselect32, _Float16, ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(argsort_parallel, \
+      _Float16, \
+      ISA_LIST("avx512_spr", "avx512_icl", "avx2")) \
+    X(argselect_parallel, \
+      _Float16, \
+      ISA_LIST("avx512_spr", "avx512_icl", "avx2"))
+#else
+#define DISPATCH_FLOAT16(X)
 #endif
 
-#define DISPATCH_ALL(func, ISA_16BIT, ISA_32BIT, ISA_64BIT) \
-    DISPATCH(func, uint16_t, ISA_16BIT) \
-    DISPATCH(func, int16_t, ISA_16BIT) \
-    DISPATCH(func, float, ISA_32BIT) \
-    DISPATCH(func, int32_t, ISA_32BIT) \
-    DISPATCH(func, uint32_t, ISA_32BIT) \
-    DISPATCH(func, int64_t, ISA_64BIT) \
-    DISPATCH(func, uint64_t, ISA_64BIT) \
-    DISPATCH(func, double, ISA_64BIT)
-
-DISPATCH_ALL(qsort,
-             (ISA_LIST("avx512_icl")),
-             (ISA_LIST("avx512_skx", "avx2")),
-             (ISA_LIST("avx512_skx", "avx2")))
-DISPATCH_ALL(qselect,
-             (ISA_LIST("avx512_icl")),
-             (ISA_LIST("avx512_skx", "avx2")),
-             (ISA_LIST("avx512_skx", "avx2")))
-DISPATCH_ALL(partial_qsort,
-             (ISA_LIST("avx512_icl")),
-             (ISA_LIST("avx512_skx", "avx2")),
-             (ISA_LIST("avx512_skx", "avx2")))
-DISPATCH_ALL(argsort,
-             (ISA_LIST("none")),
-             (ISA_LIST("avx512_skx", "avx2")),
-             (ISA_LIST("avx512_skx", "avx2")))
-DISPATCH_ALL(argselect,
-             (ISA_LIST("none")),
-             (ISA_LIST("avx512_skx", "avx2")),
-             (ISA_LIST("avx512_skx", "avx2")))
+/* __bf16 is sorted as ordered 16-bit integers and arg-sorted as float, see
+ * avx512-bf16-qsort.hpp and avx2-16bit-qsort.hpp */
+#ifdef __BFLT16_MAX__
+#define DISPATCH_BFLOAT16(X) \
+    X(qsort, __bf16, ISA_LIST("avx512_icl", "avx2")) \
+    X(qselect, __bf16, ISA_LIST("avx512_icl", "avx2")) \
+    X(partial_qsort, __bf16, ISA_LIST("avx512_icl", "avx2")) \
+    X(argsort, __bf16, ISA_LIST("avx512_skx", "avx2")) \
+    X(argselect, __bf16, ISA_LIST("avx512_skx", "avx2")) \
+    X(argsort32, __bf16, ISA_LIST("avx512_skx", "avx2")) \
+    X(argselect32, __bf16, ISA_LIST("avx512_skx", "avx2")) \
+    X(argsort_parallel, __bf16, ISA_LIST("avx512_skx", "avx2")) \
+    X(argselect_parallel, __bf16, ISA_LIST("avx512_skx", "avx2"))
+#else
+#define DISPATCH_BFLOAT16(X)
+#endif
+
+/* every dispatched routine, expanded once with X = DISPATCH to declare them,
+ * once with X = RESOLVE_DISPATCH to fill in the dispatch table and once with
+ * X = LIST_DISPATCH to report it */
+#define DISPATCH_ROUTINES(X) \
+    DISPATCH_FLOAT16(X) \
+    DISPATCH_BFLOAT16(X) \
+    DISPATCH_ALL(X, \
+                 qsort, \
+                 (ISA_LIST("avx512_zen4", "avx512_icl", "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2"))) \
+    DISPATCH_ALL(X, \
+                 qsort_parallel, \
+                 (ISA_LIST("avx512_zen4", "avx512_icl", "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2"))) \
+    DISPATCH_ALL(X, \
+                 qselect, \
+                 (ISA_LIST("avx512_zen4", "avx512_icl", "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2"))) \
+    DISPATCH_ALL(X, \
+                 partial_qsort, \
+                 (ISA_LIST("avx512_zen4", "avx512_icl", "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2"))) \
+    DISPATCH_ALL(X, \
+                 qsort_segments, \
+                 (ISA_LIST("avx512_zen4", "avx512_icl", "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2"))) \
+    DISPATCH_ALL(X, \
+                 topk_filter, \
+                 (ISA_LIST("avx512_zen4", "avx512_icl", "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2")), \
+                 (ISA_LIST("avx512_zen4", \
+                           "avx512_skx", \
+                           "avx10_256", \
+                           "avx2"))) \
+    X(strided_gather, float, ISA_LIST("avx512_skx", "avx2")) \
+    X(strided_gather, int32_t, ISA_LIST("avx512_skx", "avx2")) \
+    X(strided_gather, uint32_t, ISA_LIST("avx512_skx", "avx2")) \
+    X(strided_gather, int64_t, ISA_LIST("avx512_skx", "avx2")) \
+    X(strided_gather, uint64_t, ISA_LIST("avx512_skx", "avx2")) \
+    X(strided_gather, double, ISA_LIST("avx512_skx", "avx2")) \
+    DISPATCH_ALL(X, \
+                 argsort, \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_ALL(X, \
+                 argselect, \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_ALL(X, \
+                 argsort32, \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_ALL(X, \
+                 argselect32, \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_ALL(X, \
+                 argsort_parallel, \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_ALL(X, \
+                 argselect_parallel, \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2")), \
+                 (ISA_LIST("avx512_skx", "avx2")))
+
+DISPATCH_ROUTINES(DISPATCH)
 
 /* Key-Value methods */
 #define DECLARE_ALL_KEYVALUE_METHODS(TYPE1, TYPE2) \
     static void(CAT(CAT(*internal_keyvalue_qsort_, TYPE1), TYPE2))( \
             TYPE1 *, TYPE2 *, size_t, bool, bool) \
-            = NULL; \
+            = XSS_LAZY(CAT(CAT(internal_keyvalue_qsort_, TYPE1), TYPE2)); \
     static void(CAT(CAT(*internal_keyvalue_select_, TYPE1), TYPE2))( \
             TYPE1 *, TYPE2 *, size_t, size_t, bool, bool) \
-            = NULL; \
+            = XSS_LAZY(CAT(CAT(internal_keyvalue_select_, TYPE1), TYPE2)); \
     static void(CAT(CAT(*internal_keyvalue_partial_sort_, TYPE1), TYPE2))( \
             TYPE1 *, TYPE2 *, size_t, size_t, bool, bool) \
-            = NULL; \
+            = XSS_LAZY( \
+                    CAT(CAT(internal_keyvalue_partial_sort_, TYPE1), TYPE2)); \
     template <> \
     void keyvalue_qsort(TYPE1 *key, \
                         TYPE2 *val, \
@@ -248,17 +762,21 @@ DISPATCH_ALL(argselect,
     }
 
 #define DISPATCH_KV_FUNC(func, TYPE1, TYPE2, ISA) \
-    static __attribute__((constructor)) void CAT( \
-            CAT(CAT(CAT(resolve_, func), _), TYPE1), TYPE2)(void) \
+    static std::string_view CAT(CAT(CAT(CAT(isa_, func), _), TYPE1), TYPE2) \
+            = "scalar"; \
+    static void CAT(CAT(CAT(CAT(resolve_, func), _), TYPE1), TYPE2)( \
+            const cpu_features &features) \
     { \
         CAT(CAT(CAT(CAT(internal_, func), _), TYPE1), TYPE2) \
                 = &xss::scalar::func<TYPE1, TYPE2>; \
-        __builtin_cpu_init(); \
-        std::string_view preferred_cpu = find_preferred_cpu(ISA); \
+        CAT(CAT(CAT(CAT(isa_, func), _), TYPE1), TYPE2) = "scalar"; \
+        std::string_view preferred_cpu = find_preferred_cpu(features, ISA); \
         if constexpr (dispatch_requested("avx512", ISA)) { \
             if (preferred_cpu.find("avx512") != std::string_view::npos) { \
                 CAT(CAT(CAT(CAT(internal_, func), _), TYPE1), TYPE2) \
                         = &xss::avx512::func<TYPE1, TYPE2>; \
+                CAT(CAT(CAT(CAT(isa_, func), _), TYPE1), TYPE2) \
+                        = preferred_cpu; \
                 return; \
             } \
         } \
@@ -266,31 +784,120 @@ DISPATCH_ALL(argselect,
             if (preferred_cpu.find("avx2") != std::string_view::npos) { \
                 CAT(CAT(CAT(CAT(internal_, func), _), TYPE1), TYPE2) \
                         = &xss::avx2::func<TYPE1, TYPE2>; \
+                CAT(CAT(CAT(CAT(isa_, func), _), TYPE1), TYPE2) \
+                        = preferred_cpu; \
                 return; \
             } \
         } \
     }
 
+#define RESOLVE_KV_FUNC(func, TYPE1, TYPE2) \
+    CAT(CAT(CAT(CAT(resolve_, func), _), TYPE1), TYPE2)(features);
+
+#define LIST_KV_FUNC(func, TYPE1, TYPE2) \
+    table.push_back( \
+            {#func, \
+             #TYPE1 "," #TYPE2, \
+             std::string(CAT(CAT(CAT(CAT(isa_, func), _), TYPE1), TYPE2))});
+
 #define DISPATCH_KEYVALUE_SORT(TYPE1, TYPE2, ISA) \
     DECLARE_ALL_KEYVALUE_METHODS(TYPE1, TYPE2) \
     DISPATCH_KV_FUNC(keyvalue_qsort, TYPE1, TYPE2, ISA) \
     DISPATCH_KV_FUNC(keyvalue_select, TYPE1, TYPE2, ISA) \
     DISPATCH_KV_FUNC(keyvalue_partial_sort, TYPE1, TYPE2, ISA)
 
-#define DISPATCH_KEYVALUE_SORT_FORTYPE(type) \
-    DISPATCH_KEYVALUE_SORT(type, uint64_t, (ISA_LIST("avx512_skx", "avx2"))) \
-    DISPATCH_KEYVALUE_SORT(type, int64_t, (ISA_LIST("avx512_skx", "avx2"))) \
-    DISPATCH_KEYVALUE_SORT(type, double, (ISA_LIST("avx512_skx", "avx2"))) \
-    DISPATCH_KEYVALUE_SORT(type, uint32_t, (ISA_LIST("avx512_skx", "avx2"))) \
-    DISPATCH_KEYVALUE_SORT(type, int32_t, (ISA_LIST("avx512_skx", "avx2"))) \
-    DISPATCH_KEYVALUE_SORT(type, float, (ISA_LIST("avx512_skx", "avx2")))
-
-DISPATCH_KEYVALUE_SORT_FORTYPE(uint64_t)
-DISPATCH_KEYVALUE_SORT_FORTYPE(int64_t)
-DISPATCH_KEYVALUE_SORT_FORTYPE(double)
-DISPATCH_KEYVALUE_SORT_FORTYPE(uint32_t)
-DISPATCH_KEYVALUE_SORT_FORTYPE(int32_t)
-DISPATCH_KEYVALUE_SORT_FORTYPE(float)
+#define RESOLVE_KEYVALUE_SORT(TYPE1, TYPE2, ISA) \
+    RESOLVE_KV_FUNC(keyvalue_qsort, TYPE1, TYPE2) \
+    RESOLVE_KV_FUNC(keyvalue_select, TYPE1, TYPE2) \
+    RESOLVE_KV_FUNC(keyvalue_partial_sort, TYPE1, TYPE2)
+
+#define LIST_KEYVALUE_SORT(TYPE1, TYPE2, ISA) \
+    LIST_KV_FUNC(keyvalue_qsort, TYPE1, TYPE2) \
+    LIST_KV_FUNC(keyvalue_select, TYPE1, TYPE2) \
+    LIST_KV_FUNC(keyvalue_partial_sort, TYPE1, TYPE2)
+
+#define DISPATCH_KEYVALUE_SORT_FORTYPE(X, type) \
+    X(type, uint64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    X(type, int64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    X(type, double, (ISA_LIST("avx512_skx", "avx2"))) \
+    X(type, uint32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    X(type, int32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    X(type, float, (ISA_LIST("avx512_skx", "avx2"))) \
+    X(type, uint16_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    X(type, int16_t, (ISA_LIST("avx512_skx", "avx2")))
+
+#ifdef __FLT16_MAX__
+#define DISPATCH_KEYVALUE_FLOAT16(X) DISPATCH_KEYVALUE_SORT_FORTYPE(X, _Float16)
+#else
+#define DISPATCH_KEYVALUE_FLOAT16(X)
+#endif
+
+#define DISPATCH_KEYVALUE_ROUTINES(X) \
+    DISPATCH_KEYVALUE_SORT_FORTYPE(X, uint64_t) \
+    DISPATCH_KEYVALUE_SORT_FORTYPE(X, int64_t) \
+    DISPATCH_KEYVALUE_SORT_FORTYPE(X, double) \
+    DISPATCH_KEYVALUE_SORT_FORTYPE(X, uint32_t) \
+    DISPATCH_KEYVALUE_SORT_FORTYPE(X, int32_t) \
+    DISPATCH_KEYVALUE_SORT_FORTYPE(X, float) \
+    DISPATCH_KEYVALUE_SORT_FORTYPE(X, uint16_t) \
+    DISPATCH_KEYVALUE_SORT_FORTYPE(X, int16_t) \
+    DISPATCH_KEYVALUE_FLOAT16(X)
+
+DISPATCH_KEYVALUE_ROUTINES(DISPATCH_KEYVALUE_SORT)
+
+static std::mutex dispatch_lock;
+static cpu_features detected_features;
+static std::string preferred_isa;
+
+/* Fills in every function pointer in one pass over the routines */
+static void resolve_all(const cpu_features &features)
+{
+    DISPATCH_ROUTINES(RESOLVE_DISPATCH)
+    DISPATCH_KEYVALUE_ROUTINES(RESOLVE_KEYVALUE_SORT)
+}
+
+/* Resolves the table with CPU features that are detected only once, capped
+ * at the ISA named by XSS_PREFERRED_ISA if it is set. Runs on the first call
+ * of any dispatched routine rather than at load time, so a process that never
+ * sorts does not pay for it. */
+static void resolve_dispatch_table()
+{
+    static std::once_flag resolved;
+    std::call_once(resolved, []() {
+        detected_features = detect_cpu_features();
+        const char *env_isa = std::getenv("XSS_PREFERRED_ISA");
+        if (env_isa && is_known_isa(env_isa)) { preferred_isa = env_isa; }
+        resolve_all(cap_cpu_features(detected_features, preferred_isa));
+    });
+}
+
+bool set_preferred_isa(std::string_view isa)
+{
+    if (!isa.empty() && !is_known_isa(isa)) return false;
+    resolve_dispatch_table();
+    std::lock_guard<std::mutex> lk(dispatch_lock);
+    preferred_isa = isa;
+    resolve_all(cap_cpu_features(detected_features, preferred_isa));
+    return true;
+}
+
+std::vector<dispatch_entry> get_dispatch_table()
+{
+    resolve_dispatch_table();
+    std::lock_guard<std::mutex> lk(dispatch_lock);
+    std::vector<dispatch_entry> table;
+    DISPATCH_ROUTINES(LIST_DISPATCH)
+    DISPATCH_KEYVALUE_ROUTINES(LIST_KEYVALUE_SORT)
+    return table;
+}
+
+std::string get_dispatched_isa(std::string_view routine, std::string_view type)
+{
+    for (const auto &entry : get_dispatch_table()) {
+        if (entry.routine == routine && entry.type == type) return entry.isa;
+    }
+    return "";
+}
 
 } // namespace x86simdsort
 //
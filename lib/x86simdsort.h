@@ -2,9 +2,17 @@
 #define X86_SIMD_SORT
 #include <stdint.h>
 #include <vector>
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <numeric>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 #define XSS_EXPORT_SYMBOL __attribute__((visibility("default")))
 #define XSS_HIDE_SYMBOL __attribute__((visibility("hidden")))
@@ -17,6 +25,31 @@ template <typename T>
 XSS_EXPORT_SYMBOL void
 qsort(T *arr, size_t arrsize, bool hasnan = false, bool descending = false);
 
+// executor used by the parallel methods: submit() must run every job exactly
+// once, on any thread (running it inline is allowed too)
+class XSS_EXPORT_SYMBOL executor {
+public:
+    virtual ~executor() = default;
+    virtual void submit(std::function<void()> job) = 0;
+};
+
+// parallel quicksort on a work-stealing thread pool owned by the library,
+// num_threads = 0 uses one thread per hardware thread
+template <typename T>
+XSS_EXPORT_SYMBOL void qsort_parallel(T *arr,
+                                      size_t arrsize,
+                                      int num_threads = 0,
+                                      bool hasnan = false,
+                                      bool descending = false);
+
+// parallel quicksort on a caller provided executor
+template <typename T>
+XSS_EXPORT_SYMBOL void qsort_parallel(T *arr,
+                                      size_t arrsize,
+                                      executor &ex,
+                                      bool hasnan = false,
+                                      bool descending = false);
+
 // quickselect
 template <typename T>
 XSS_EXPORT_SYMBOL void qselect(T *arr,
@@ -33,6 +66,31 @@ XSS_EXPORT_SYMBOL void partial_qsort(T *arr,
                                      bool hasnan = false,
                                      bool descending = false);
 
+// sort num_segments independent arrays stored back to back in arr, segment ii
+// is arr[offsets[ii]] ... arr[offsets[ii + 1] - 1]
+template <typename T>
+XSS_EXPORT_SYMBOL void qsort_segments(T *arr,
+                                      const size_t *offsets,
+                                      size_t num_segments,
+                                      bool hasnan = false,
+                                      bool descending = false);
+
+// copy the elements of arr that are strictly smaller than threshold (larger
+// if descending) to out, which needs room for arrsize elements, and return how
+// many were copied; NaNs are never copied
+template <typename T>
+XSS_EXPORT_SYMBOL size_t topk_filter(const T *arr,
+                                     size_t arrsize,
+                                     T threshold,
+                                     T *out,
+                                     bool descending = false);
+
+// copy the T found ii * stride bytes past base to out[ii], e.g. one member of
+// every element of an array of structs; T must be a 32-bit or 64-bit type
+template <typename T>
+XSS_EXPORT_SYMBOL void
+strided_gather(const void *base, size_t stride, size_t arrsize, T *out);
+
 // argsort
 template <typename T>
 XSS_EXPORT_SYMBOL std::vector<size_t>
@@ -43,6 +101,94 @@ template <typename T>
 XSS_EXPORT_SYMBOL std::vector<size_t>
 argselect(T *arr, size_t k, size_t arrsize, bool hasnan = false);
 
+// argsort into a caller provided buffer of arrsize indices, its contents on
+// entry are ignored
+template <typename T>
+XSS_EXPORT_SYMBOL void argsort(T *arr,
+                               size_t *arg,
+                               size_t arrsize,
+                               bool hasnan = false,
+                               bool descending = false);
+
+// argselect into a caller provided buffer of arrsize indices
+template <typename T>
+XSS_EXPORT_SYMBOL void argselect(
+        T *arr, size_t *arg, size_t k, size_t arrsize, bool hasnan = false);
+
+// argsort and argselect with 32-bit indices, arrsize must fit in 32 bits
+template <typename T>
+XSS_EXPORT_SYMBOL void argsort(T *arr,
+                               uint32_t *arg,
+                               size_t arrsize,
+                               bool hasnan = false,
+                               bool descending = false);
+
+template <typename T>
+XSS_EXPORT_SYMBOL void argselect(
+        T *arr, uint32_t *arg, size_t k, size_t arrsize, bool hasnan = false);
+
+// parallel argsort on the library's thread pool (num_threads = 0) or on a
+// pool of num_threads threads
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t> argsort_parallel(T *arr,
+                                                       size_t arrsize,
+                                                       int num_threads = 0,
+                                                       bool hasnan = false,
+                                                       bool descending = false);
+
+// parallel argsort on a caller provided executor
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t> argsort_parallel(T *arr,
+                                                       size_t arrsize,
+                                                       executor &ex,
+                                                       bool hasnan = false,
+                                                       bool descending = false);
+
+// parallel argselect: the index array is filled in parallel
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t> argselect_parallel(T *arr,
+                                                         size_t k,
+                                                         size_t arrsize,
+                                                         int num_threads = 0,
+                                                         bool hasnan = false);
+
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t> argselect_parallel(
+        T *arr, size_t k, size_t arrsize, executor &ex, bool hasnan = false);
+
+// parallel argsort/argselect into a caller provided buffer
+template <typename T>
+XSS_EXPORT_SYMBOL void argsort_parallel(T *arr,
+                                        size_t *arg,
+                                        size_t arrsize,
+                                        int num_threads = 0,
+                                        bool hasnan = false,
+                                        bool descending = false);
+
+template <typename T>
+XSS_EXPORT_SYMBOL void argsort_parallel(T *arr,
+                                        size_t *arg,
+                                        size_t arrsize,
+                                        executor &ex,
+                                        bool hasnan = false,
+                                        bool descending = false);
+
+template <typename T>
+XSS_EXPORT_SYMBOL void argselect_parallel(T *arr,
+                                          size_t *arg,
+                                          size_t k,
+                                          size_t arrsize,
+                                          int num_threads = 0,
+                                          bool hasnan = false);
+
+template <typename T>
+XSS_EXPORT_SYMBOL void argselect_parallel(T *arr,
+                                          size_t *arg,
+                                          size_t k,
+                                          size_t arrsize,
+                                          executor &ex,
+                                          bool hasnan = false);
+
 // keyvalue sort
 template <typename T1, typename T2>
 XSS_EXPORT_SYMBOL void keyvalue_qsort(T1 *key,
@@ -69,41 +215,453 @@ XSS_EXPORT_SYMBOL void keyvalue_partial_sort(T1 *key,
                                              bool hasnan = false,
                                              bool descending = false);
 
+// one entry of the runtime dispatch table: the ISA ("avx512_skx", "avx2",
+// "scalar", ...) a routine resolved to for a type, or for a "key,value" pair
+// of types in case of the keyvalue methods
+struct dispatch_entry {
+    std::string routine;
+    std::string type;
+    std::string isa;
+};
+
+// the dispatch table, resolved on the first call to any routine of the
+// library (or to this function)
+XSS_EXPORT_SYMBOL std::vector<dispatch_entry> get_dispatch_table();
+
+// Caps the ISA every routine may dispatch to at isa, one of "avx512_zen4",
+// "avx512_spr", "avx512_icl", "avx512_skx", "avx10_256", "avx2" or "scalar"
+// (from most to least preferred), and re-resolves the table.
+// Routines never dispatch to an ISA the CPU lacks, and "" lifts the cap. The
+// XSS_PREFERRED_ISA environment variable sets the cap the table is first
+// resolved with. Returns false (and changes nothing) for an unknown name.
+// Must not be called while another thread is inside the library.
+XSS_EXPORT_SYMBOL bool set_preferred_isa(std::string_view isa);
+
+// ISA a routine resolved to for a type name as it appears in the dispatch
+// table, or "" if there is no such entry
+XSS_EXPORT_SYMBOL std::string get_dispatched_isa(std::string_view routine,
+                                                 std::string_view type);
+
+namespace detail {
+    template <typename T>
+    struct dispatch_type_name;
+#define XSS_DISPATCH_TYPE_NAME(TYPE) \
+    template <> \
+    struct dispatch_type_name<TYPE> { \
+        static constexpr const char *value = #TYPE; \
+    };
+    XSS_DISPATCH_TYPE_NAME(uint16_t)
+    XSS_DISPATCH_TYPE_NAME(int16_t)
+    XSS_DISPATCH_TYPE_NAME(float)
+    XSS_DISPATCH_TYPE_NAME(uint32_t)
+    XSS_DISPATCH_TYPE_NAME(int32_t)
+    XSS_DISPATCH_TYPE_NAME(double)
+    XSS_DISPATCH_TYPE_NAME(uint64_t)
+    XSS_DISPATCH_TYPE_NAME(int64_t)
+#ifdef __FLT16_MAX__
+    XSS_DISPATCH_TYPE_NAME(_Float16)
+#endif
+#ifdef __BFLT16_MAX__
+    XSS_DISPATCH_TYPE_NAME(__bf16)
+#endif
+#undef XSS_DISPATCH_TYPE_NAME
+} // namespace detail
+
+// ISA a routine resolved to for T, e.g. get_dispatched_isa<float>("qsort"),
+// or for a key-value pair of types, e.g.
+// get_dispatched_isa<uint64_t, double>("keyvalue_qsort")
+template <typename... T>
+std::string get_dispatched_isa(std::string_view routine)
+{
+    std::string type;
+    ((type += type.empty() ? "" : ",",
+      type += detail::dispatch_type_name<T>::value),
+     ...);
+    return get_dispatched_isa(routine, type);
+}
+
+namespace detail {
+    // Moves arr[arg[ii]] to arr[ii]. Trivially copyable objects are gathered
+    // into a scratch buffer, prefetching the objects a few iterations ahead of
+    // the copy, and written back in one sequential pass. Other types are
+    // permuted in place by following the cycles of arg, which needs no copies.
+    template <typename T, typename U>
+    void object_permute(T *arr, U *arg, size_t arrsize)
+    {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            constexpr size_t prefetch_dist = 16;
+            std::allocator<T> alloc;
+            T *buf = alloc.allocate(arrsize);
+            size_t ii = 0;
+            for (; ii + prefetch_dist < arrsize; ++ii) {
+                __builtin_prefetch(arr + arg[ii + prefetch_dist]);
+                std::memcpy(buf + ii, arr + arg[ii], sizeof(T));
+            }
+            for (; ii < arrsize; ++ii) {
+                std::memcpy(buf + ii, arr + arg[ii], sizeof(T));
+            }
+            std::memcpy(arr, buf, arrsize * sizeof(T));
+            alloc.deallocate(buf, arrsize);
+        }
+        else {
+            std::vector<bool> done(arrsize);
+            for (size_t i = 0; i < arrsize; ++i) {
+                if (done[i]) { continue; }
+                done[i] = true;
+                size_t prev_j = i;
+                size_t j = arg[i];
+                while (i != j) {
+                    std::swap(arr[prev_j], arr[j]);
+                    done[j] = true;
+                    prev_j = j;
+                    j = arg[j];
+                }
+            }
+        }
+    }
+
+    // Sorts every run of equal keys[] by key_func, so that the objects end up
+    // ordered lexicographically by (first key, key_func)
+    template <typename T, typename K, typename U, typename Func>
+    void object_sort_ties(
+            T *arr, K *keys, U *arg, size_t arrsize, Func key_func)
+    {
+        using key_t = std::decay_t<std::invoke_result_t<Func, T &>>;
+        static_assert(sizeof(key_t) == sizeof(int32_t)
+                              || sizeof(key_t) == sizeof(int64_t),
+                      "key_func return type must be 32 or 64 bits");
+        std::vector<key_t> tie_keys;
+        size_t start = 0;
+        for (size_t ii = 1; ii <= arrsize; ++ii) {
+            if (ii < arrsize && keys[ii] == keys[start]) { continue; }
+            size_t len = ii - start;
+            if (len > 1) {
+                tie_keys.resize(len);
+                for (size_t jj = 0; jj < len; ++jj) {
+                    tie_keys[jj] = key_func(arr[arg[start + jj]]);
+                }
+                x86simdsort::keyvalue_qsort(tie_keys.data(), arg + start, len);
+            }
+            start = ii;
+        }
+    }
+
+    // equality that also treats any two NaNs as equal keys
+    template <typename K>
+    bool same_key(K a, K b)
+    {
+        if (a != a) { return b != b; }
+        return a == b;
+    }
+
+    // Sorts the indices within every run of equal keys[], which turns the
+    // result of an unstable key-value sort of (key, index) into a stable one
+    template <typename K, typename U>
+    void stable_ties(K *keys, U *arg, size_t arrsize)
+    {
+        size_t start = 0;
+        for (size_t ii = 1; ii <= arrsize; ++ii) {
+            if (ii < arrsize && same_key(keys[ii], keys[start])) { continue; }
+            if (ii - start > 1) { x86simdsort::qsort(arg + start, ii - start); }
+            start = ii;
+        }
+    }
+
+    // Key functor that loads one member of every object with strided_gather
+    template <auto member>
+    struct member_key {
+        template <typename T>
+        auto operator()(const T &obj) const
+        {
+            return obj.*member;
+        }
+        template <typename T, typename K>
+        void operator()(const T *objs, size_t arrsize, K *keys) const
+        {
+            if (arrsize == 0) { return; }
+            const char *first = (const char *)&(objs->*member);
+            x86simdsort::strided_gather(first, sizeof(T), arrsize, keys);
+        }
+    };
+
+    template <typename U,
+              bool stable,
+              typename T,
+              typename Func,
+              typename... Funcs>
+    void object_qsort(T *arr, size_t arrsize, Func key_func, Funcs... next)
+    {
+        using key_t = std::decay_t<std::invoke_result_t<Func, T &>>;
+        static_assert(sizeof(key_t) == sizeof(int32_t)
+                              || sizeof(key_t) == sizeof(int64_t),
+                      "key_func return type must be 32 or 64 bits");
+        static_assert(sizeof...(Funcs) <= 1,
+                      "object_qsort supports up to two sort keys");
+        static_assert(!stable || sizeof...(Funcs) == 0,
+                      "stable object sort supports a single sort key");
+
+        /* (1) Fill keys and indices in a single pass over the objects, or
+         * let a key functor that takes a whole array fill the keys at once */
+        std::unique_ptr<key_t[]> keys(new key_t[arrsize]);
+        std::unique_ptr<U[]> arg(new U[arrsize]);
+        if constexpr (std::is_invocable_v<Func, const T *, size_t, key_t *>) {
+            key_func((const T *)arr, arrsize, keys.get());
+            std::iota(arg.get(), arg.get() + arrsize, 0);
+        }
+        else {
+            for (size_t ii = 0; ii < arrsize; ++ii) {
+                keys[ii] = key_func(arr[ii]);
+                arg[ii] = (U)ii;
+            }
+        }
+
+        /* (2) Sort the indices with the keys, then break the ties */
+        x86simdsort::keyvalue_qsort(keys.get(), arg.get(), arrsize);
+        if constexpr (sizeof...(Funcs) > 0) {
+            object_sort_ties(arr, keys.get(), arg.get(), arrsize, next...);
+        }
+        if constexpr (stable) { stable_ties(keys.get(), arg.get(), arrsize); }
+        keys.reset();
+
+        /* (3) Move the objects to their sorted positions */
+        object_permute(arr, arg.get(), arrsize);
+    }
+
+    template <bool stable, typename T, typename U, typename... Funcs>
+    void object_qsort_any_index(T *arr, U arrsize, Funcs... key_funcs)
+    {
+        static_assert(std::is_integral<U>::value,
+                      "arrsize must be an integral type");
+        static_assert(sizeof(U) == sizeof(int32_t)
+                              || sizeof(U) == sizeof(int64_t),
+                      "arrsize must be 32 or 64 bits");
+        // 32-bit indices halve the index traffic of the key-value sort
+        // whenever they can address the whole array
+        if ((uint64_t)arrsize <= UINT32_MAX) {
+            object_qsort<uint32_t, stable>(
+                    arr, (size_t)arrsize, key_funcs...);
+        }
+        else {
+            object_qsort<uint64_t, stable>(
+                    arr, (size_t)arrsize, key_funcs...);
+        }
+    }
+    template <typename U, typename T1, typename T2>
+    void keyvalue_stable_sort(
+            T1 *key, T2 *val, size_t arrsize, bool hasnan, bool descending)
+    {
+        std::unique_ptr<U[]> arg(new U[arrsize]);
+        std::iota(arg.get(), arg.get() + arrsize, 0);
+        x86simdsort::keyvalue_qsort(
+                key, arg.get(), arrsize, hasnan, descending);
+        stable_ties(key, arg.get(), arrsize);
+        object_permute(val, arg.get(), arrsize);
+    }
+} // namespace detail
+
+// stable keyvalue sort: values with equal keys keep their relative order
+template <typename T1, typename T2>
+XSS_EXPORT_SYMBOL void keyvalue_stable_sort(T1 *key,
+                                            T2 *val,
+                                            size_t arrsize,
+                                            bool hasnan = false,
+                                            bool descending = false)
+{
+    if (arrsize <= UINT32_MAX) {
+        detail::keyvalue_stable_sort<uint32_t>(
+                key, val, arrsize, hasnan, descending);
+    }
+    else {
+        detail::keyvalue_stable_sort<uint64_t>(
+                key, val, arrsize, hasnan, descending);
+    }
+}
+
+// stable argsort: indices of equal elements stay in increasing order
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t> stable_argsort(T *arr,
+                                                     size_t arrsize,
+                                                     bool hasnan = false,
+                                                     bool descending = false)
+{
+    std::vector<T> keys(arr, arr + arrsize);
+    std::vector<size_t> arg(arrsize);
+    std::iota(arg.begin(), arg.end(), 0);
+    x86simdsort::keyvalue_qsort(
+            keys.data(), arg.data(), arrsize, hasnan, descending);
+    detail::stable_ties(keys.data(), arg.data(), arrsize);
+    return arg;
+}
+
 // sort an object
 template <typename T, typename U, typename Func>
 XSS_EXPORT_SYMBOL void object_qsort(T *arr, U arrsize, Func key_func)
 {
-    static_assert(std::is_integral<U>::value, "arrsize must be an integral type");
-    static_assert(sizeof(U) == sizeof(int32_t) || sizeof(U) == sizeof(int64_t),
-                  "arrsize must be 32 or 64 bits");
-    using return_type_of = typename decltype(std::function{key_func})::result_type;
-    static_assert(sizeof(return_type_of) == sizeof(int32_t) || sizeof(return_type_of) == sizeof(int64_t),
-                  "key_func return type must be 32 or 64 bits");
-    std::vector<return_type_of> keys(arrsize);
-    for (U ii = 0; ii < arrsize; ++ii) {
-        keys[ii] = key_func(arr[ii]);
-    }
-
-    /* (2) Call arg based on keys using the keyvalue sort */
-    std::vector<U> arg(arrsize);
-    std::iota(arg.begin(), arg.end(), 0);
-    x86simdsort::keyvalue_qsort(keys.data(), arg.data(), arrsize);
-
-    /* (3) Permute obj array in-place */
-    std::vector<bool> done(arrsize);
-    for (U i = 0; i < arrsize; ++i) {
-        if (done[i]) { continue; }
-        done[i] = true;
-        U prev_j = i;
-        U j = arg[i];
-        while (i != j) {
-            std::swap(arr[prev_j], arr[j]);
-            done[j] = true;
-            prev_j = j;
-            j = arg[j];
+    detail::object_qsort_any_index<false>(arr, arrsize, key_func);
+}
+
+// sort an object by one of its members, e.g.
+// object_qsort_by_member<&Point::x>(arr, arrsize); the keys are loaded with
+// hardware gathers instead of one call per object
+template <auto member, typename T, typename U>
+XSS_EXPORT_SYMBOL void object_qsort_by_member(T *arr, U arrsize)
+{
+    detail::object_qsort_any_index<false>(
+            arr, arrsize, detail::member_key<member> {});
+}
+
+// sort an object, keeping the relative order of objects with equal keys
+template <typename T, typename U, typename Func>
+XSS_EXPORT_SYMBOL void object_stable_sort(T *arr, U arrsize, Func key_func)
+{
+    detail::object_qsort_any_index<true>(arr, arrsize, key_func);
+}
+
+// sort an object lexicographically by a tuple of one or two keys
+template <typename T, typename U, typename... Funcs>
+XSS_EXPORT_SYMBOL void
+object_qsort(T *arr, U arrsize, std::tuple<Funcs...> key_funcs)
+{
+    std::apply(
+            [&](auto... funcs) {
+                detail::object_qsort_any_index<false>(arr, arrsize, funcs...);
+            },
+            key_funcs);
+}
+
+// Keeps the k smallest (largest if descending) elements of a stream that is
+// pushed chunk by chunk, in O(k) memory. NaNs are ignored. The candidates live
+// in a buffer of 2k + chunk_size elements: every chunk is filtered against the
+// worst of the current best k, and whenever more than 2k candidates have piled
+// up they are cut back to the best k with qselect, which tightens the filter.
+template <typename T>
+class topk_accumulator {
+public:
+    explicit topk_accumulator(size_t k, bool descending = false)
+        : k(k), descending(descending), buf(2 * k + chunk_size)
+    {
+    }
+
+    void push(const T *chunk, size_t n)
+    {
+        if (k == 0) { return; }
+        // The filter needs a threshold, i.e. k elements seen so far
+        for (; n > 0 && count < k; ++chunk, --n) {
+            if (*chunk == *chunk) { buf[count++] = *chunk; }
+            if (count == k) { shrink(); }
+        }
+        while (n > 0) {
+            size_t len = std::min(n, buf.size() - count);
+            count += x86simdsort::topk_filter(
+                    chunk, len, threshold, buf.data() + count, descending);
+            chunk += len;
+            n -= len;
+            if (count > 2 * k) { shrink(); }
         }
     }
-}
+
+    // the best min(k, number of non-NaN elements pushed) elements, sorted;
+    // more chunks can still be pushed afterwards
+    std::vector<T> finalize()
+    {
+        size_t num = std::min(k, count);
+        x86simdsort::partial_qsort(buf.data(), num, count, false, descending);
+        return std::vector<T>(buf.begin(), buf.begin() + num);
+    }
+
+private:
+    static constexpr size_t chunk_size = 1024;
+
+    void shrink()
+    {
+        x86simdsort::qselect(buf.data(), k - 1, count, false, descending);
+        threshold = buf[k - 1];
+        count = k;
+    }
+
+    size_t k;
+    bool descending;
+    std::vector<T> buf;
+    size_t count = 0;
+    T threshold = T();
+};
+
+// topk_accumulator for key-value pairs, ranked by key
+template <typename T1, typename T2>
+class keyvalue_topk_accumulator {
+public:
+    explicit keyvalue_topk_accumulator(size_t k, bool descending = false)
+        : k(k)
+        , descending(descending)
+        , keys(2 * k + chunk_size)
+        , vals(2 * k + chunk_size)
+    {
+    }
+
+    void push(const T1 *key, const T2 *val, size_t n)
+    {
+        if (k == 0) { return; }
+        for (; n > 0 && count < k; ++key, ++val, --n) {
+            if (*key == *key) {
+                keys[count] = *key;
+                vals[count++] = *val;
+            }
+            if (count == k) { shrink(); }
+        }
+        while (n > 0) {
+            size_t len = std::min(n, chunk_size);
+            // The filter only runs on the keys: the rare blocks that hold a
+            // candidate are scanned again to pick up the matching values
+            if (x86simdsort::topk_filter(
+                        key, len, threshold, keys.data() + count, descending)
+                > 0) {
+                for (size_t ii = 0; ii < len; ++ii) {
+                    if (better(key[ii])) {
+                        keys[count] = key[ii];
+                        vals[count++] = val[ii];
+                    }
+                }
+            }
+            key += len;
+            val += len;
+            n -= len;
+            if (count > 2 * k) { shrink(); }
+        }
+    }
+
+    // the best min(k, number of non-NaN keys pushed) pairs, sorted by key
+    std::pair<std::vector<T1>, std::vector<T2>> finalize()
+    {
+        size_t num = std::min(k, count);
+        x86simdsort::keyvalue_partial_sort(
+                keys.data(), vals.data(), num, count, false, descending);
+        return {std::vector<T1>(keys.begin(), keys.begin() + num),
+                std::vector<T2>(vals.begin(), vals.begin() + num)};
+    }
+
+private:
+    static constexpr size_t chunk_size = 1024;
+
+    bool better(T1 key) const
+    {
+        return descending ? threshold < key : key < threshold;
+    }
+
+    void shrink()
+    {
+        x86simdsort::keyvalue_select(
+                keys.data(), vals.data(), k - 1, count, false, descending);
+        threshold = keys[k - 1];
+        count = k;
+    }
+
+    size_t k;
+    bool descending;
+    std::vector<T1> keys;
+    std::vector<T2> vals;
+    size_t count = 0;
+    T1 threshold = T1();
+};
 
 } // namespace x86simdsort
 #endif
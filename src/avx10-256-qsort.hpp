@@ -0,0 +1,193 @@
+/*******************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause
+ * ****************************************************************/
+#ifndef AVX10_256_QSORT
+#define AVX10_256_QSORT
+
+#include "avx2-32bit-qsort.hpp"
+#include "avx2-64bit-qsort.hpp"
+
+/*
+ * AVX10.1/256 CPUs (hybrid and E-core parts) support the AVX-512 instruction
+ * forms on ymm registers only, and servers that throttle on 512-bit code run
+ * them at full clock. avx10_256_vector<T> is avx2_vector<T> with its
+ * emulated masks replaced by __mmask8 opmasks: compares, masked loads, stores
+ * and blends use the EVEX forms, and the partition compress-stores with
+ * vpcompress instead of the permutation tables of avx2-emu-funcs.hpp.
+ */
+template <typename T>
+struct avx10_256_vector : avx2_vector<T> {
+    using base = avx2_vector<T>;
+    using type_t = typename base::type_t;
+    using reg_t = typename base::reg_t;
+    using opmask_t = __mmask8;
+    static constexpr simd_type vec_type = simd_type::AVX512;
+    static constexpr opmask_t lanemask = (1 << base::numlanes) - 1;
+
+    template <int fp_predicate, int int_predicate>
+    static opmask_t cmp(reg_t x, reg_t y)
+    {
+        if constexpr (std::is_same_v<type_t, float>) {
+            return _mm256_cmp_ps_mask(x, y, fp_predicate);
+        }
+        else if constexpr (std::is_same_v<type_t, double>) {
+            return _mm256_cmp_pd_mask(x, y, fp_predicate);
+        }
+        else if constexpr (sizeof(type_t) == 4) {
+            if constexpr (std::is_signed_v<type_t>) {
+                return _mm256_cmp_epi32_mask(x, y, int_predicate);
+            }
+            else {
+                return _mm256_cmp_epu32_mask(x, y, int_predicate);
+            }
+        }
+        else {
+            if constexpr (std::is_signed_v<type_t>) {
+                return _mm256_cmp_epi64_mask(x, y, int_predicate);
+            }
+            else {
+                return _mm256_cmp_epu64_mask(x, y, int_predicate);
+            }
+        }
+    }
+    static opmask_t ge(reg_t x, reg_t y)
+    {
+        return cmp<_CMP_GE_OQ, _MM_CMPINT_NLT>(x, y);
+    }
+    static opmask_t gt(reg_t x, reg_t y)
+    {
+        return cmp<_CMP_GT_OQ, _MM_CMPINT_NLE>(x, y);
+    }
+    static opmask_t eq(reg_t x, reg_t y)
+    {
+        return cmp<_CMP_EQ_OQ, _MM_CMPINT_EQ>(x, y);
+    }
+    static opmask_t knot_opmask(opmask_t x)
+    {
+        return (opmask_t)(~x & lanemask);
+    }
+    static opmask_t kxor_opmask(opmask_t x, opmask_t y)
+    {
+        return x ^ y;
+    }
+    static opmask_t get_partial_loadmask(uint64_t num_to_read)
+    {
+        return ((0x1ull << num_to_read) - 0x1ull);
+    }
+    static opmask_t convert_int_to_mask(uint64_t intMask)
+    {
+        return intMask;
+    }
+    static int32_t convert_mask_to_int(opmask_t mask)
+    {
+        return mask;
+    }
+    static bool all_false(opmask_t k)
+    {
+        return k == 0;
+    }
+    template <int type>
+    static opmask_t fpclass(reg_t x)
+    {
+        if constexpr (std::is_same_v<type_t, float>) {
+            return _mm256_fpclass_ps_mask(x, type);
+        }
+        else {
+            return _mm256_fpclass_pd_mask(x, type);
+        }
+    }
+    static reg_t max(reg_t x, reg_t y)
+    {
+        if constexpr (std::is_same_v<type_t, int64_t>) {
+            return _mm256_max_epi64(x, y);
+        }
+        else if constexpr (std::is_same_v<type_t, uint64_t>) {
+            return _mm256_max_epu64(x, y);
+        }
+        else {
+            return base::max(x, y);
+        }
+    }
+    static reg_t min(reg_t x, reg_t y)
+    {
+        if constexpr (std::is_same_v<type_t, int64_t>) {
+            return _mm256_min_epi64(x, y);
+        }
+        else if constexpr (std::is_same_v<type_t, uint64_t>) {
+            return _mm256_min_epu64(x, y);
+        }
+        else {
+            return base::min(x, y);
+        }
+    }
+    static reg_t maskz_loadu(opmask_t mask, void const *mem)
+    {
+        if constexpr (sizeof(type_t) == 4) {
+            return base::cast_from(_mm256_maskz_loadu_epi32(mask, mem));
+        }
+        else {
+            return base::cast_from(_mm256_maskz_loadu_epi64(mask, mem));
+        }
+    }
+    static reg_t mask_loadu(reg_t x, opmask_t mask, void const *mem)
+    {
+        __m256i v = base::cast_to(x);
+        if constexpr (sizeof(type_t) == 4) {
+            return base::cast_from(_mm256_mask_loadu_epi32(v, mask, mem));
+        }
+        else {
+            return base::cast_from(_mm256_mask_loadu_epi64(v, mask, mem));
+        }
+    }
+    static reg_t mask_mov(reg_t x, opmask_t mask, reg_t y)
+    {
+        __m256i v1 = base::cast_to(x);
+        __m256i v2 = base::cast_to(y);
+        if constexpr (sizeof(type_t) == 4) {
+            return base::cast_from(_mm256_mask_mov_epi32(v1, mask, v2));
+        }
+        else {
+            return base::cast_from(_mm256_mask_mov_epi64(v1, mask, v2));
+        }
+    }
+    static void mask_storeu(void *mem, opmask_t mask, reg_t x)
+    {
+        if constexpr (sizeof(type_t) == 4) {
+            _mm256_mask_storeu_epi32(mem, mask, base::cast_to(x));
+        }
+        else {
+            _mm256_mask_storeu_epi64(mem, mask, base::cast_to(x));
+        }
+    }
+    static void mask_compressstoreu(void *mem, opmask_t mask, reg_t x)
+    {
+        if constexpr (sizeof(type_t) == 4) {
+            _mm256_mask_compressstoreu_epi32(mem, mask, base::cast_to(x));
+        }
+        else {
+            _mm256_mask_compressstoreu_epi64(mem, mask, base::cast_to(x));
+        }
+    }
+    static reg_t sort_vec(reg_t x)
+    {
+        if constexpr (base::numlanes == 8) {
+            return sort_reg_8lanes<avx10_256_vector<type_t>>(x);
+        }
+        else {
+            return sort_reg_4lanes<avx10_256_vector<type_t>>(x);
+        }
+    }
+    static int double_compressstore(type_t *left_addr,
+                                    type_t *right_addr,
+                                    opmask_t k,
+                                    reg_t reg)
+    {
+        return avx512_double_compressstore<avx10_256_vector<type_t>>(
+                left_addr, right_addr, k, reg);
+    }
+};
+
+DEFINE_METHODS(avx10_256, avx10_256_vector<T>)
+
+#endif // AVX10_256_QSORT
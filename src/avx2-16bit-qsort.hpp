@@ -0,0 +1,591 @@
+/*******************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause
+ * ****************************************************************/
+
+#ifndef AVX2_QSORT_16BIT
+#define AVX2_QSORT_16BIT
+
+#include "avx2-emu-funcs.hpp"
+
+struct avx2_16bit_swizzle_ops;
+
+template <>
+struct avx2_vector<int16_t> {
+    using type_t = int16_t;
+    using reg_t = __m256i;
+    using ymmi_t = __m256i;
+    using opmask_t = __m256i;
+    static const uint8_t numlanes = 16;
+#ifdef XSS_MINIMAL_NETWORK_SORT
+    static constexpr int network_sort_threshold = numlanes;
+#else
+    static constexpr int network_sort_threshold = 256;
+#endif
+    static constexpr int partition_unroll_factor = 4;
+    static constexpr simd_type vec_type = simd_type::AVX2;
+
+    using swizzle_ops = avx2_16bit_swizzle_ops;
+
+    static type_t type_max()
+    {
+        return X86_SIMD_SORT_MAX_INT16;
+    }
+    static type_t type_min()
+    {
+        return X86_SIMD_SORT_MIN_INT16;
+    }
+    static reg_t zmm_max()
+    {
+        return _mm256_set1_epi16(type_max());
+    }
+    static reg_t zmm_min()
+    {
+        return _mm256_set1_epi16(type_min());
+    }
+    static opmask_t knot_opmask(opmask_t x)
+    {
+        return _mm256_xor_si256(x, _mm256_set1_epi16(-1));
+    }
+    static opmask_t get_partial_loadmask(uint64_t num_to_read)
+    {
+        const __m256i lanes = _mm256_setr_epi16(
+                0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        return _mm256_cmpgt_epi16(_mm256_set1_epi16((int16_t)num_to_read),
+                                  lanes);
+    }
+    static opmask_t convert_int_to_mask(uint64_t intMask)
+    {
+        return convert_int_to_avx2_mask_16bit(intMask);
+    }
+    static int32_t convert_mask_to_int(opmask_t mask)
+    {
+        return convert_avx2_mask_to_int_16bit(mask);
+    }
+    static opmask_t ge(reg_t x, reg_t y)
+    {
+        return eq(max(x, y), x);
+    }
+    static opmask_t eq(reg_t x, reg_t y)
+    {
+        return _mm256_cmpeq_epi16(x, y);
+    }
+    static reg_t loadu(void const *mem)
+    {
+        return _mm256_loadu_si256((reg_t const *)mem);
+    }
+    static reg_t max(reg_t x, reg_t y)
+    {
+        return _mm256_max_epi16(x, y);
+    }
+    static reg_t mask_loadu(reg_t x, opmask_t mask, void const *mem)
+    {
+        return avx2_emu_mask_loadu16<type_t>(x, mask, mem);
+    }
+    static reg_t mask_mov(reg_t x, opmask_t mask, reg_t y)
+    {
+        return _mm256_blendv_epi8(x, y, mask);
+    }
+    static void mask_storeu(void *mem, opmask_t mask, reg_t x)
+    {
+        return avx2_emu_mask_storeu16<type_t>(mem, mask, x);
+    }
+    static reg_t min(reg_t x, reg_t y)
+    {
+        return _mm256_min_epi16(x, y);
+    }
+    static reg_t reverse(reg_t ymm)
+    {
+        const __m256i rev_index = _mm256_setr_epi8(14,
+                                                   15,
+                                                   12,
+                                                   13,
+                                                   10,
+                                                   11,
+                                                   8,
+                                                   9,
+                                                   6,
+                                                   7,
+                                                   4,
+                                                   5,
+                                                   2,
+                                                   3,
+                                                   0,
+                                                   1,
+                                                   14,
+                                                   15,
+                                                   12,
+                                                   13,
+                                                   10,
+                                                   11,
+                                                   8,
+                                                   9,
+                                                   6,
+                                                   7,
+                                                   4,
+                                                   5,
+                                                   2,
+                                                   3,
+                                                   0,
+                                                   1);
+        ymm = _mm256_shuffle_epi8(ymm, rev_index);
+        return _mm256_permute4x64_epi64(ymm, 0b01001110);
+    }
+    static type_t reducemax(reg_t v)
+    {
+        __m128i x = _mm_max_epi16(_mm256_castsi256_si128(v),
+                                  _mm256_extracti128_si256(v, 1));
+        return avx2_emu_minpos16<0x7FFF>(x);
+    }
+    static type_t reducemin(reg_t v)
+    {
+        __m128i x = _mm_min_epi16(_mm256_castsi256_si128(v),
+                                  _mm256_extracti128_si256(v, 1));
+        return avx2_emu_minpos16<0x8000>(x);
+    }
+    static reg_t set1(type_t v)
+    {
+        return _mm256_set1_epi16(v);
+    }
+    static void storeu(void *mem, reg_t x)
+    {
+        _mm256_storeu_si256((__m256i *)mem, x);
+    }
+    static reg_t sort_vec(reg_t x)
+    {
+        return sort_reg_16lanes<avx2_vector<type_t>>(x);
+    }
+    static reg_t cast_from(__m256i v)
+    {
+        return v;
+    }
+    static __m256i cast_to(reg_t v)
+    {
+        return v;
+    }
+    static bool all_false(opmask_t k)
+    {
+        return _mm256_testz_si256(k, k);
+    }
+    static int double_compressstore(type_t *left_addr,
+                                    type_t *right_addr,
+                                    opmask_t k,
+                                    reg_t reg)
+    {
+        return avx2_double_compressstore16<type_t>(
+                left_addr, right_addr, k, reg);
+    }
+};
+template <>
+struct avx2_vector<uint16_t> {
+    using type_t = uint16_t;
+    using reg_t = __m256i;
+    using ymmi_t = __m256i;
+    using opmask_t = __m256i;
+    static const uint8_t numlanes = 16;
+#ifdef XSS_MINIMAL_NETWORK_SORT
+    static constexpr int network_sort_threshold = numlanes;
+#else
+    static constexpr int network_sort_threshold = 256;
+#endif
+    static constexpr int partition_unroll_factor = 4;
+    static constexpr simd_type vec_type = simd_type::AVX2;
+
+    using swizzle_ops = avx2_16bit_swizzle_ops;
+
+    static type_t type_max()
+    {
+        return X86_SIMD_SORT_MAX_UINT16;
+    }
+    static type_t type_min()
+    {
+        return 0;
+    }
+    static reg_t zmm_max()
+    {
+        return _mm256_set1_epi16((int16_t)type_max());
+    }
+    static reg_t zmm_min()
+    {
+        return _mm256_set1_epi16(type_min());
+    }
+    static opmask_t knot_opmask(opmask_t x)
+    {
+        return _mm256_xor_si256(x, _mm256_set1_epi16(-1));
+    }
+    static opmask_t get_partial_loadmask(uint64_t num_to_read)
+    {
+        return avx2_vector<int16_t>::get_partial_loadmask(num_to_read);
+    }
+    static opmask_t convert_int_to_mask(uint64_t intMask)
+    {
+        return convert_int_to_avx2_mask_16bit(intMask);
+    }
+    static int32_t convert_mask_to_int(opmask_t mask)
+    {
+        return convert_avx2_mask_to_int_16bit(mask);
+    }
+    static opmask_t ge(reg_t x, reg_t y)
+    {
+        return eq(max(x, y), x);
+    }
+    static opmask_t eq(reg_t x, reg_t y)
+    {
+        return _mm256_cmpeq_epi16(x, y);
+    }
+    static reg_t loadu(void const *mem)
+    {
+        return _mm256_loadu_si256((reg_t const *)mem);
+    }
+    static reg_t max(reg_t x, reg_t y)
+    {
+        return _mm256_max_epu16(x, y);
+    }
+    static reg_t mask_loadu(reg_t x, opmask_t mask, void const *mem)
+    {
+        return avx2_emu_mask_loadu16<type_t>(x, mask, mem);
+    }
+    static reg_t mask_mov(reg_t x, opmask_t mask, reg_t y)
+    {
+        return _mm256_blendv_epi8(x, y, mask);
+    }
+    static void mask_storeu(void *mem, opmask_t mask, reg_t x)
+    {
+        return avx2_emu_mask_storeu16<type_t>(mem, mask, x);
+    }
+    static reg_t min(reg_t x, reg_t y)
+    {
+        return _mm256_min_epu16(x, y);
+    }
+    static reg_t reverse(reg_t ymm)
+    {
+        return avx2_vector<int16_t>::reverse(ymm);
+    }
+    static type_t reducemax(reg_t v)
+    {
+        __m128i x = _mm_max_epu16(_mm256_castsi256_si128(v),
+                                  _mm256_extracti128_si256(v, 1));
+        return avx2_emu_minpos16<0xFFFF>(x);
+    }
+    static type_t reducemin(reg_t v)
+    {
+        __m128i x = _mm_min_epu16(_mm256_castsi256_si128(v),
+                                  _mm256_extracti128_si256(v, 1));
+        return avx2_emu_minpos16<0x0000>(x);
+    }
+    static reg_t set1(type_t v)
+    {
+        return _mm256_set1_epi16((int16_t)v);
+    }
+    static void storeu(void *mem, reg_t x)
+    {
+        _mm256_storeu_si256((__m256i *)mem, x);
+    }
+    static reg_t sort_vec(reg_t x)
+    {
+        return sort_reg_16lanes<avx2_vector<type_t>>(x);
+    }
+    static reg_t cast_from(__m256i v)
+    {
+        return v;
+    }
+    static __m256i cast_to(reg_t v)
+    {
+        return v;
+    }
+    static bool all_false(opmask_t k)
+    {
+        return _mm256_testz_si256(k, k);
+    }
+    static int double_compressstore(type_t *left_addr,
+                                    type_t *right_addr,
+                                    opmask_t k,
+                                    reg_t reg)
+    {
+        return avx2_double_compressstore16<type_t>(
+                left_addr, right_addr, k, reg);
+    }
+};
+
+struct avx2_16bit_swizzle_ops {
+    template <typename vtype, int scale>
+    X86_SIMD_SORT_INLINE typename vtype::reg_t swap_n(typename vtype::reg_t reg)
+    {
+        __m256i v = vtype::cast_to(reg);
+
+        if constexpr (scale == 2) {
+            const __m256i mask = _mm256_setr_epi8(2,
+                                                  3,
+                                                  0,
+                                                  1,
+                                                  6,
+                                                  7,
+                                                  4,
+                                                  5,
+                                                  10,
+                                                  11,
+                                                  8,
+                                                  9,
+                                                  14,
+                                                  15,
+                                                  12,
+                                                  13,
+                                                  2,
+                                                  3,
+                                                  0,
+                                                  1,
+                                                  6,
+                                                  7,
+                                                  4,
+                                                  5,
+                                                  10,
+                                                  11,
+                                                  8,
+                                                  9,
+                                                  14,
+                                                  15,
+                                                  12,
+                                                  13);
+            v = _mm256_shuffle_epi8(v, mask);
+        }
+        else if constexpr (scale == 4) {
+            v = _mm256_shuffle_epi32(v, 0b10110001);
+        }
+        else if constexpr (scale == 8) {
+            v = _mm256_shuffle_epi32(v, 0b01001110);
+        }
+        else if constexpr (scale == 16) {
+            v = _mm256_permute4x64_epi64(v, 0b01001110);
+        }
+        else {
+            static_assert(scale == -1, "should not be reached");
+        }
+
+        return vtype::cast_from(v);
+    }
+
+    template <typename vtype, int scale>
+    X86_SIMD_SORT_INLINE typename vtype::reg_t
+    reverse_n(typename vtype::reg_t reg)
+    {
+        __m256i v = vtype::cast_to(reg);
+
+        if constexpr (scale == 2) { return swap_n<vtype, 2>(reg); }
+        else if constexpr (scale == 4) {
+            const __m256i mask = _mm256_setr_epi8(6,
+                                                  7,
+                                                  4,
+                                                  5,
+                                                  2,
+                                                  3,
+                                                  0,
+                                                  1,
+                                                  14,
+                                                  15,
+                                                  12,
+                                                  13,
+                                                  10,
+                                                  11,
+                                                  8,
+                                                  9,
+                                                  6,
+                                                  7,
+                                                  4,
+                                                  5,
+                                                  2,
+                                                  3,
+                                                  0,
+                                                  1,
+                                                  14,
+                                                  15,
+                                                  12,
+                                                  13,
+                                                  10,
+                                                  11,
+                                                  8,
+                                                  9);
+            v = _mm256_shuffle_epi8(v, mask);
+        }
+        else if constexpr (scale == 8) {
+            const __m256i mask = _mm256_setr_epi8(14,
+                                                  15,
+                                                  12,
+                                                  13,
+                                                  10,
+                                                  11,
+                                                  8,
+                                                  9,
+                                                  6,
+                                                  7,
+                                                  4,
+                                                  5,
+                                                  2,
+                                                  3,
+                                                  0,
+                                                  1,
+                                                  14,
+                                                  15,
+                                                  12,
+                                                  13,
+                                                  10,
+                                                  11,
+                                                  8,
+                                                  9,
+                                                  6,
+                                                  7,
+                                                  4,
+                                                  5,
+                                                  2,
+                                                  3,
+                                                  0,
+                                                  1);
+            v = _mm256_shuffle_epi8(v, mask);
+        }
+        else if constexpr (scale == 16) {
+            return vtype::reverse(reg);
+        }
+        else {
+            static_assert(scale == -1, "should not be reached");
+        }
+
+        return vtype::cast_from(v);
+    }
+
+    template <typename vtype, int scale>
+    X86_SIMD_SORT_INLINE typename vtype::reg_t
+    merge_n(typename vtype::reg_t reg, typename vtype::reg_t other)
+    {
+        __m256i v1 = vtype::cast_to(reg);
+        __m256i v2 = vtype::cast_to(other);
+
+        if constexpr (scale == 2) {
+            v1 = _mm256_blend_epi16(v1, v2, 0b01010101);
+        }
+        else if constexpr (scale == 4) {
+            v1 = _mm256_blend_epi16(v1, v2, 0b00110011);
+        }
+        else if constexpr (scale == 8) {
+            v1 = _mm256_blend_epi16(v1, v2, 0b00001111);
+        }
+        else if constexpr (scale == 16) {
+            v1 = _mm256_blend_epi32(v1, v2, 0b00001111);
+        }
+        else {
+            static_assert(scale == -1, "should not be reached");
+        }
+
+        return vtype::cast_from(v1);
+    }
+};
+
+/*
+ * _Float16 and bfloat16 are sorted with the uint16_t kernels, the same way as
+ * bfloat16 is with AVX-512 (see avx512-bf16-qsort.hpp): the bits are mapped in
+ * place to integers with the same order and back. inf_bits is +inf, anything
+ * above it once the sign is cleared is a NaN.
+ */
+template <uint16_t inf_bits>
+struct avx2_16bit_ordered {
+    using vtype = avx2_vector<uint16_t>;
+    using reg_t = __m256i;
+
+    static reg_t to_ordered(reg_t x)
+    {
+        reg_t abs = _mm256_and_si256(x, _mm256_set1_epi16(0x7fff));
+        reg_t nanmask = _mm256_cmpgt_epi16(abs, _mm256_set1_epi16(inf_bits));
+        x = _mm256_blendv_epi8(x, abs, nanmask);
+        reg_t flip = _mm256_or_si256(_mm256_srai_epi16(x, 15),
+                                     _mm256_set1_epi16((int16_t)0x8000));
+        return _mm256_xor_si256(x, flip);
+    }
+    static reg_t from_ordered(reg_t x)
+    {
+        reg_t flip = _mm256_or_si256(
+                _mm256_andnot_si256(_mm256_srai_epi16(x, 15),
+                                    _mm256_set1_epi16(0x7fff)),
+                _mm256_set1_epi16((int16_t)0x8000));
+        return _mm256_xor_si256(x, flip);
+    }
+    template <reg_t (*convert)(reg_t)>
+    static void apply(uint16_t *arr, arrsize_t arrsize)
+    {
+        arrsize_t ii = 0;
+        for (; ii + vtype::numlanes <= arrsize; ii += vtype::numlanes) {
+            vtype::storeu(arr + ii, convert(vtype::loadu(arr + ii)));
+        }
+        if (ii < arrsize) {
+            auto load_mask = vtype::get_partial_loadmask(arrsize - ii);
+            reg_t x = vtype::mask_loadu(vtype::zmm_min(), load_mask, arr + ii);
+            vtype::mask_storeu(arr + ii, load_mask, convert(x));
+        }
+    }
+};
+
+using avx2_fp16_ordered = avx2_16bit_ordered<0x7c00>;
+using avx2_bf16_ordered = avx2_16bit_ordered<0x7f80>;
+
+template <typename ordered>
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx2_qsort_ordered(uint16_t *arr, arrsize_t arrsize, bool descending)
+{
+    if (arrsize <= 1) return;
+    ordered::template apply<ordered::to_ordered>(arr, arrsize);
+    avx2_qsort(arr, arrsize, false, descending);
+    ordered::template apply<ordered::from_ordered>(arr, arrsize);
+}
+
+template <typename ordered, typename executor_t>
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx2_qsort_parallel_ordered(uint16_t *arr,
+                            arrsize_t arrsize,
+                            executor_t &ex,
+                            bool descending)
+{
+    if (arrsize <= 1) return;
+    ordered::template apply<ordered::to_ordered>(arr, arrsize);
+    avx2_qsort_parallel(arr, arrsize, ex, false, descending);
+    ordered::template apply<ordered::from_ordered>(arr, arrsize);
+}
+
+template <typename ordered>
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx2_qselect_ordered(uint16_t *arr,
+                     arrsize_t k,
+                     arrsize_t arrsize,
+                     bool descending)
+{
+    if (arrsize <= 1) return;
+    ordered::template apply<ordered::to_ordered>(arr, arrsize);
+    avx2_qselect(arr, k, arrsize, false, descending);
+    ordered::template apply<ordered::from_ordered>(arr, arrsize);
+}
+
+template <typename ordered>
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx2_partial_qsort_ordered(uint16_t *arr,
+                           arrsize_t k,
+                           arrsize_t arrsize,
+                           bool descending)
+{
+    if (k == 0) return;
+    ordered::template apply<ordered::to_ordered>(arr, arrsize);
+    avx2_partial_qsort(arr, k, arrsize, false, descending);
+    ordered::template apply<ordered::from_ordered>(arr, arrsize);
+}
+
+template <typename ordered>
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx2_qsort_segments_ordered(uint16_t *arr,
+                            const arrsize_t *offsets,
+                            arrsize_t num_segments,
+                            bool descending)
+{
+    if (num_segments == 0) return;
+    uint16_t *first = arr + offsets[0];
+    arrsize_t arrsize = offsets[num_segments] - offsets[0];
+    ordered::template apply<ordered::to_ordered>(first, arrsize);
+    avx2_qsort_segments(arr, offsets, num_segments, false, descending);
+    ordered::template apply<ordered::from_ordered>(first, arrsize);
+}
+
+#endif // AVX2_QSORT_16BIT
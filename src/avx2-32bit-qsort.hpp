@@ -82,7 +82,8 @@ struct avx2_vector<int32_t> {
     static reg_t
     mask_i64gather(reg_t src, opmask_t mask, __m256i index, void const *base)
     {
-        return _mm256_mask_i32gather_epi32(src, base, index, mask, scale);
+        return _mm256_mask_i32gather_epi32(
+                src, (int const *)base, index, mask, scale);
     }
     template <int scale>
     static reg_t i64gather(__m256i index, void const *base)
@@ -240,7 +241,8 @@ struct avx2_vector<uint32_t> {
     static reg_t
     mask_i64gather(reg_t src, opmask_t mask, __m256i index, void const *base)
     {
-        return _mm256_mask_i32gather_epi32(src, base, index, mask, scale);
+        return _mm256_mask_i32gather_epi32(
+                src, (int const *)base, index, mask, scale);
     }
     template <int scale>
     static reg_t i64gather(__m256i index, void const *base)
@@ -427,8 +429,11 @@ struct avx2_vector<float> {
     static reg_t
     mask_i64gather(reg_t src, opmask_t mask, __m256i index, void const *base)
     {
-        return _mm256_mask_i32gather_ps(
-                src, base, index, _mm256_castsi256_ps(mask), scale);
+        return _mm256_mask_i32gather_ps(src,
+                                        (float const *)base,
+                                        index,
+                                        _mm256_castsi256_ps(mask),
+                                        scale);
         ;
     }
     template <int scale>
@@ -143,6 +143,23 @@ constexpr auto avx2_compressstore_lut64_perm
 constexpr auto avx2_compressstore_lut64_left
         = avx2_compressstore_lut64_gen.second;
 
+constexpr auto avx2_compressstore_lut16_half_perm = [] {
+    std::array<std::array<uint8_t, 16>, 256> permLut {};
+    for (int64_t i = 0; i <= 0xFF; i++) {
+        std::array<uint8_t, 16> indices {};
+        int right = 7;
+        int left = 0;
+        for (int j = 0; j < 8; j++) {
+            bool ge = (i >> j) & 1;
+            int dst = ge ? right-- : left++;
+            indices[2 * dst] = 2 * j;
+            indices[2 * dst + 1] = 2 * j + 1;
+        }
+        permLut[i] = indices;
+    }
+    return permLut;
+}();
+
 X86_SIMD_SORT_INLINE
 __m256i convert_int_to_avx2_mask(int32_t m)
 {
@@ -182,6 +199,37 @@ int32_t convert_avx2_mask_to_int_half(__m128i m)
     return _mm_movemask_ps(_mm_castsi128_ps(m));
 }
 
+X86_SIMD_SORT_INLINE
+__m256i convert_int_to_avx2_mask_16bit(int32_t m)
+{
+    const __m256i bits = _mm256_setr_epi16(0x0001,
+                                           0x0002,
+                                           0x0004,
+                                           0x0008,
+                                           0x0010,
+                                           0x0020,
+                                           0x0040,
+                                           0x0080,
+                                           0x0100,
+                                           0x0200,
+                                           0x0400,
+                                           0x0800,
+                                           0x1000,
+                                           0x2000,
+                                           0x4000,
+                                           (int16_t)0x8000);
+    __m256i set = _mm256_and_si256(_mm256_set1_epi16((int16_t)m), bits);
+    return _mm256_cmpeq_epi16(set, bits);
+}
+
+X86_SIMD_SORT_INLINE
+int32_t convert_avx2_mask_to_int_16bit(__m256i m)
+{
+    __m128i packed = _mm_packs_epi16(_mm256_castsi256_si128(m),
+                                     _mm256_extracti128_si256(m, 1));
+    return _mm_movemask_epi8(packed);
+}
+
 // Emulators for intrinsics missing from AVX2 compared to AVX512
 template <typename T>
 T avx2_emu_reduce_max32(typename avx2_vector<T>::reg_t x)
@@ -261,6 +309,19 @@ T avx2_emu_reduce_min64(typename avx2_vector<T>::reg_t x)
     return std::min(arr[0], arr[3]);
 }
 
+/*
+ * _mm_minpos_epu16 finds the smallest of eight unsigned 16-bit lanes. flip is
+ * xor-ed in and out to reduce in any other order: 0x8000 turns int16_t into
+ * unsigned order, 0xFFFF and 0x7FFF turn a maximum into a minimum.
+ */
+template <uint16_t flip>
+X86_SIMD_SORT_INLINE uint16_t avx2_emu_minpos16(__m128i x)
+{
+    const __m128i f = _mm_set1_epi16((int16_t)flip);
+    __m128i minpos = _mm_minpos_epu16(_mm_xor_si128(x, f));
+    return (uint16_t)_mm_cvtsi128_si32(minpos) ^ flip;
+}
+
 template <typename T>
 void avx2_emu_mask_compressstoreu32(void *base_addr,
                                     typename avx2_vector<T>::opmask_t k,
@@ -396,6 +457,93 @@ int32_t avx2_double_compressstore64(void *left_addr,
     return _mm_popcnt_u32(shortMask);
 }
 
+/*
+ * AVX2 has no 16-bit masked loads and stores. Pairs of lanes that are both set
+ * use the 32-bit ones, the lanes left over (at most one for the prefix masks
+ * of the sorting networks) are copied one at a time.
+ */
+template <typename T>
+typename avx2_vector<T>::reg_t
+avx2_emu_mask_loadu16(typename avx2_vector<T>::reg_t x,
+                      typename avx2_vector<T>::opmask_t k,
+                      void const *mem)
+{
+    const T *src = (const T *)mem;
+    __m256i pairs = _mm256_cmpeq_epi32(k, _mm256_set1_epi32(-1));
+    __m256i dst = _mm256_maskload_epi32((const int *)mem, pairs);
+    x = _mm256_blendv_epi8(x, dst, pairs);
+
+    int32_t rest
+            = convert_avx2_mask_to_int_16bit(_mm256_andnot_si256(pairs, k));
+    while (rest != 0) {
+        int32_t lane = rest & -rest;
+        int32_t j = _mm_popcnt_u32(lane - 1);
+        x = _mm256_blendv_epi8(x,
+                               _mm256_set1_epi16(src[j]),
+                               convert_int_to_avx2_mask_16bit(lane));
+        rest ^= lane;
+    }
+    return x;
+}
+
+template <typename T>
+void avx2_emu_mask_storeu16(void *mem,
+                            typename avx2_vector<T>::opmask_t k,
+                            typename avx2_vector<T>::reg_t x)
+{
+    T *dst = (T *)mem;
+    __m256i pairs = _mm256_cmpeq_epi32(k, _mm256_set1_epi32(-1));
+    _mm256_maskstore_epi32((int *)mem, pairs, x);
+
+    int32_t rest
+            = convert_avx2_mask_to_int_16bit(_mm256_andnot_si256(pairs, k));
+    if (rest != 0) {
+        T src[avx2_vector<T>::numlanes];
+        _mm256_storeu_si256((__m256i *)src, x);
+        while (rest != 0) {
+            int32_t lane = rest & -rest;
+            int32_t j = _mm_popcnt_u32(lane - 1);
+            dst[j] = src[j];
+            rest ^= lane;
+        }
+    }
+}
+
+/*
+ * Each 128-bit half is compressed on its own with pshufb. The halves are then
+ * stored so that the lanes of the low half come first on both sides, which
+ * also leaves every lane in place when left_addr and right_addr are the same
+ * (the last vector of a partition).
+ */
+template <typename T>
+int avx2_double_compressstore16(void *left_addr,
+                                void *right_addr,
+                                typename avx2_vector<T>::opmask_t k,
+                                typename avx2_vector<T>::reg_t reg)
+{
+    T *leftStore = (T *)left_addr;
+    T *rightStore = (T *)right_addr;
+
+    int32_t shortMask = convert_avx2_mask_to_int_16bit(k);
+    int32_t maskLo = shortMask & 0xFF;
+    int32_t maskHi = shortMask >> 8;
+    const __m128i permLo = _mm_loadu_si128(
+            (const __m128i *)avx2_compressstore_lut16_half_perm[maskLo].data());
+    const __m128i permHi = _mm_loadu_si128(
+            (const __m128i *)avx2_compressstore_lut16_half_perm[maskHi].data());
+
+    __m128i lo = _mm_shuffle_epi8(_mm256_castsi256_si128(reg), permLo);
+    __m128i hi = _mm_shuffle_epi8(_mm256_extracti128_si256(reg, 1), permHi);
+    int32_t amountLo = _mm_popcnt_u32(maskLo);
+
+    _mm_storeu_si128((__m128i *)(rightStore + 8), lo);
+    _mm_storeu_si128((__m128i *)leftStore, lo);
+    _mm_storeu_si128((__m128i *)(leftStore + 8 - amountLo), hi);
+    _mm_storeu_si128((__m128i *)(rightStore + 8 - amountLo), hi);
+
+    return amountLo + _mm_popcnt_u32(maskHi);
+}
+
 template <typename T>
 typename avx2_vector<T>::reg_t avx2_emu_max(typename avx2_vector<T>::reg_t x,
                                             typename avx2_vector<T>::reg_t y)
@@ -548,6 +548,8 @@ avx512_qsort_fp16_helper(uint16_t *arr, arrsize_t arrsize)
     using T = uint16_t;
     using vtype = zmm_vector<float16>;
 
+    if (qsort_presorted_<vtype, comparator, T>(arr, arrsize)) return;
+
 #ifdef XSS_COMPILE_OPENMP
     bool use_parallel = arrsize > 100000;
 
@@ -594,10 +596,48 @@ avx512_qsort_fp16(uint16_t *arr,
             nan_count = replace_nan_with_inf<vtype, uint16_t>(arr, arrsize);
         }
         if (descending) {
-            avx512_qsort_fp16_helper<Comparator<vtype, true>>(arr, arrsize);
+            if (!xss_radix_qsort<uint16_t, true, true>(arr, arrsize)) {
+                avx512_qsort_fp16_helper<Comparator<vtype, true>>(arr,
+                                                                  arrsize);
+            }
+        }
+        else {
+            if (!xss_radix_qsort<uint16_t, false, true>(arr, arrsize)) {
+                avx512_qsort_fp16_helper<Comparator<vtype, false>>(arr,
+                                                                   arrsize);
+            }
+        }
+        replace_inf_with_nan(arr, arrsize, nan_count, descending);
+    }
+
+#ifdef __MMX__
+    // Workaround for compiler bug generating MMX instructions without emms
+    _mm_empty();
+#endif
+}
+
+template <typename executor_t>
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx512_qsort_parallel_fp16(uint16_t *arr,
+                           arrsize_t arrsize,
+                           executor_t &ex,
+                           bool hasnan = false,
+                           bool descending = false)
+{
+    using vtype = zmm_vector<float16>;
+
+    if (arrsize > 1) {
+        arrsize_t nan_count = 0;
+        if (UNLIKELY(hasnan)) {
+            nan_count = replace_nan_with_inf<vtype, uint16_t>(arr, arrsize);
+        }
+        if (descending) {
+            qsort_parallel_helper<vtype, Comparator<vtype, true>>(
+                    arr, arrsize, ex);
         }
         else {
-            avx512_qsort_fp16_helper<Comparator<vtype, false>>(arr, arrsize);
+            qsort_parallel_helper<vtype, Comparator<vtype, false>>(
+                    arr, arrsize, ex);
         }
         replace_inf_with_nan(arr, arrsize, nan_count, descending);
     }
@@ -668,4 +708,62 @@ avx512_partial_qsort_fp16(uint16_t *arr,
     avx512_qselect_fp16(arr, k - 1, arrsize, hasnan, descending);
     avx512_qsort_fp16(arr, k - 1, hasnan, descending);
 }
+
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx512_qsort_segments_fp16(uint16_t *arr,
+                           const arrsize_t *offsets,
+                           arrsize_t num_segments,
+                           bool hasnan = false,
+                           bool descending = false)
+{
+    using vtype = zmm_vector<float16>;
+
+    for (arrsize_t ii = 0; ii < num_segments; ++ii) {
+        uint16_t *seg = arr + offsets[ii];
+        arrsize_t size = offsets[ii + 1] - offsets[ii];
+        if (size <= 1) continue;
+
+        arrsize_t nan_count = 0;
+        if (UNLIKELY(hasnan)) {
+            nan_count = replace_nan_with_inf<vtype, uint16_t>(seg, size);
+        }
+        if (descending) {
+            qsort_segment_<vtype, Comparator<vtype, true>>(seg, size);
+        }
+        else {
+            qsort_segment_<vtype, Comparator<vtype, false>>(seg, size);
+        }
+        replace_inf_with_nan(seg, size, nan_count, descending);
+    }
+
+#ifdef __MMX__
+    // Workaround for compiler bug generating MMX instructions without emms
+    _mm_empty();
+#endif
+}
+
+[[maybe_unused]] X86_SIMD_SORT_INLINE arrsize_t
+avx512_topk_filter_fp16(const uint16_t *arr,
+                        arrsize_t arrsize,
+                        uint16_t threshold,
+                        uint16_t *out,
+                        bool descending = false)
+{
+    using vtype = zmm_vector<float16>;
+    arrsize_t count;
+    if (descending) {
+        count = topk_filter_copy_<vtype, Comparator<vtype, true>>(
+                arr, arrsize, threshold, out);
+    }
+    else {
+        count = topk_filter_copy_<vtype, Comparator<vtype, false>>(
+                arr, arrsize, threshold, out);
+    }
+
+#ifdef __MMX__
+    // Workaround for compiler bug generating MMX instructions without emms
+    _mm_empty();
+#endif
+    return count;
+}
 #endif // AVX512_QSORT_16BIT
@@ -66,6 +66,12 @@ struct zmm_vector<int32_t> {
     {
         return _mm512_i64gather_epi32(index, base, scale);
     }
+    template <int scale>
+    static reg_t
+    mask_i64gather(reg_t src, opmask_t mask, __m512i index, void const *base)
+    {
+        return _mm512_mask_i32gather_epi32(src, mask, index, base, scale);
+    }
     static reg_t merge(halfreg_t y1, halfreg_t y2)
     {
         reg_t z1 = _mm512_castsi256_si512(y1);
@@ -237,6 +243,12 @@ struct zmm_vector<uint32_t> {
     {
         return _mm512_i64gather_epi32(index, base, scale);
     }
+    template <int scale>
+    static reg_t
+    mask_i64gather(reg_t src, opmask_t mask, __m512i index, void const *base)
+    {
+        return _mm512_mask_i32gather_epi32(src, mask, index, base, scale);
+    }
     static reg_t merge(halfreg_t y1, halfreg_t y2)
     {
         reg_t z1 = _mm512_castsi256_si512(y1);
@@ -449,6 +461,12 @@ struct zmm_vector<float> {
     {
         return _mm512_i64gather_ps(index, base, scale);
     }
+    template <int scale>
+    static reg_t
+    mask_i64gather(reg_t src, opmask_t mask, __m512i index, void const *base)
+    {
+        return _mm512_mask_i32gather_ps(src, mask, index, base, scale);
+    }
     static reg_t merge(halfreg_t y1, halfreg_t y2)
     {
         reg_t z1 = _mm512_castsi512_ps(
@@ -0,0 +1,102 @@
+/*******************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause
+ * ****************************************************************/
+
+#ifndef AVX512_QSORT_BF16
+#define AVX512_QSORT_BF16
+
+#include "avx512-16bit-common.h"
+
+/*
+ * bfloat16 is sorted with the uint16_t kernels: the bits of every element are
+ * mapped in place to an unsigned integer with the same order (the sign bit is
+ * set on positive numbers and every bit is flipped on negative ones), sorted,
+ * and mapped back. The sign of NaNs is cleared on the way in, so that all of
+ * them order after +inf, otherwise their bits are kept. -0.0 orders before
+ * +0.0.
+ */
+struct avx512_bf16_ordered {
+    using reg_t = __m512i;
+    using opmask_t = __mmask32;
+    static constexpr int numlanes = 32;
+
+    static reg_t to_ordered(reg_t x)
+    {
+        const reg_t abs_mask = _mm512_set1_epi16(0x7fff);
+        opmask_t nanmask = _mm512_cmpgt_epu16_mask(
+                _mm512_and_si512(x, abs_mask), _mm512_set1_epi16(0x7f80));
+        x = _mm512_mask_mov_epi16(x, nanmask, _mm512_and_si512(x, abs_mask));
+        reg_t flip = _mm512_or_si512(_mm512_srai_epi16(x, 15),
+                                     _mm512_set1_epi16((int16_t)0x8000));
+        return _mm512_xor_si512(x, flip);
+    }
+    static reg_t from_ordered(reg_t x)
+    {
+        reg_t flip = _mm512_or_si512(
+                _mm512_andnot_si512(_mm512_srai_epi16(x, 15),
+                                    _mm512_set1_epi16(0x7fff)),
+                _mm512_set1_epi16((int16_t)0x8000));
+        return _mm512_xor_si512(x, flip);
+    }
+    template <reg_t (*convert)(reg_t)>
+    static void apply(uint16_t *arr, arrsize_t arrsize)
+    {
+        arrsize_t ii = 0;
+        for (; ii + numlanes <= arrsize; ii += numlanes) {
+            reg_t x = _mm512_loadu_si512(arr + ii);
+            _mm512_storeu_si512(arr + ii, convert(x));
+        }
+        if (ii < arrsize) {
+            opmask_t load_mask = ((opmask_t)1 << (arrsize - ii)) - 1;
+            reg_t x = _mm512_maskz_loadu_epi16(load_mask, arr + ii);
+            _mm512_mask_storeu_epi16(arr + ii, load_mask, convert(x));
+        }
+    }
+};
+
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx512_qsort_bf16(uint16_t *arr,
+                  arrsize_t arrsize,
+                  bool hasnan = false,
+                  bool descending = false)
+{
+    UNUSED(hasnan);
+    if (arrsize <= 1) return;
+    using ordered = avx512_bf16_ordered;
+    ordered::apply<ordered::to_ordered>(arr, arrsize);
+    avx512_qsort(arr, arrsize, false, descending);
+    ordered::apply<ordered::from_ordered>(arr, arrsize);
+}
+
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx512_qselect_bf16(uint16_t *arr,
+                    arrsize_t k,
+                    arrsize_t arrsize,
+                    bool hasnan = false,
+                    bool descending = false)
+{
+    UNUSED(hasnan);
+    if (arrsize <= 1) return;
+    using ordered = avx512_bf16_ordered;
+    ordered::apply<ordered::to_ordered>(arr, arrsize);
+    avx512_qselect(arr, k, arrsize, false, descending);
+    ordered::apply<ordered::from_ordered>(arr, arrsize);
+}
+
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx512_partial_qsort_bf16(uint16_t *arr,
+                          arrsize_t k,
+                          arrsize_t arrsize,
+                          bool hasnan = false,
+                          bool descending = false)
+{
+    UNUSED(hasnan);
+    if (k == 0) return;
+    using ordered = avx512_bf16_ordered;
+    ordered::apply<ordered::to_ordered>(arr, arrsize);
+    avx512_partial_qsort(arr, k, arrsize, false, descending);
+    ordered::apply<ordered::from_ordered>(arr, arrsize);
+}
+
+#endif // AVX512_QSORT_BF16
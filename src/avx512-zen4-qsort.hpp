@@ -0,0 +1,62 @@
+/*******************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause
+ * ****************************************************************/
+#ifndef AVX512_QSORT_ZEN4
+#define AVX512_QSORT_ZEN4
+
+/*
+ * AMD Zen4 and Zen5 implement vpcompress with a register destination in a
+ * couple of uops, but microcode it when the destination is memory. That makes
+ * the mask_compressstoreu based double_compressstore of the zmm_vector types
+ * slower than the AVX2 emulation. zen4_vector<vtype> is vtype with a
+ * double_compressstore that compresses both sides of the partition within a
+ * register, false lanes at the bottom and true lanes at the top, and writes it
+ * with two plain stores. That is the layout the AVX2 partition already uses,
+ * so the extra lanes only land on slots the partition overwrites later.
+ */
+template <typename vtype>
+struct zen4_vector : vtype {
+    using type_t = typename vtype::type_t;
+    using reg_t = typename vtype::reg_t;
+    using opmask_t = typename vtype::opmask_t;
+
+    static int double_compressstore(type_t *left_addr,
+                                    type_t *right_addr,
+                                    opmask_t k,
+                                    reg_t reg)
+    {
+        int amount_ge_pivot = _mm_popcnt_u32((uint32_t)k);
+        /* the top amount_ge_pivot lanes receive the elements of mask k */
+        opmask_t top = (opmask_t)(~0ull << (vtype::numlanes - amount_ge_pivot));
+        opmask_t notk = vtype::knot_opmask(k);
+        reg_t packed;
+        if constexpr (sizeof(type_t) == 2) {
+            packed = _mm512_mask_expand_epi16(
+                    _mm512_maskz_compress_epi16(notk, reg),
+                    top,
+                    _mm512_maskz_compress_epi16(k, reg));
+        }
+        else if constexpr (sizeof(type_t) == 4) {
+            __m512i v = vtype::cast_to(reg);
+            packed = vtype::cast_from(_mm512_mask_expand_epi32(
+                    _mm512_maskz_compress_epi32(notk, v),
+                    top,
+                    _mm512_maskz_compress_epi32(k, v)));
+        }
+        else {
+            __m512i v = vtype::cast_to(reg);
+            packed = vtype::cast_from(_mm512_mask_expand_epi64(
+                    _mm512_maskz_compress_epi64(notk, v),
+                    top,
+                    _mm512_maskz_compress_epi64(k, v)));
+        }
+        vtype::storeu(left_addr, packed);
+        vtype::storeu(right_addr, packed);
+        return amount_ge_pivot;
+    }
+};
+
+DEFINE_METHODS(zen4, zen4_vector<zmm_vector<T>>)
+
+#endif // AVX512_QSORT_ZEN4
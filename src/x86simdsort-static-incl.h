@@ -24,6 +24,51 @@ X86_SIMD_SORT_FINLINE void partial_qsort(T *arr,
                                          bool hasnan = false,
                                          bool descending = false);
 
+/* Sorts num_segments independent arrays stored back to back in arr, segment
+ * ii being arr[offsets[ii]] ... arr[offsets[ii + 1] - 1]: */
+template <typename T>
+X86_SIMD_SORT_FINLINE void qsort_segments(T *arr,
+                                          const size_t *offsets,
+                                          size_t num_segments,
+                                          bool hasnan = false,
+                                          bool descending = false);
+
+/* Copies the elements of arr that are strictly smaller than threshold (larger
+ * if descending) to out, which needs room for size elements, and returns how
+ * many were copied. NaNs are never copied: */
+template <typename T>
+X86_SIMD_SORT_FINLINE size_t topk_filter(const T *arr,
+                                         size_t size,
+                                         T threshold,
+                                         T *out,
+                                         bool descending = false);
+
+/* Copies the T found ii * stride bytes past base to out[ii], for 32-bit and
+ * 64-bit T, e.g. to load one member of every element of an array of structs: */
+template <typename T>
+X86_SIMD_SORT_FINLINE void
+strided_gather(const void *base, size_t stride, size_t size, T *out);
+
+/* Multi-threaded quicksort on a thread pool of num_threads workers (0 = one
+ * per hardware thread) that is created for the duration of the call: */
+template <typename T>
+X86_SIMD_SORT_FINLINE void qsort_parallel(T *arr,
+                                          size_t size,
+                                          int num_threads = 0,
+                                          bool hasnan = false,
+                                          bool descending = false);
+
+/* Multi-threaded quicksort on a caller provided executor, i.e. any object
+ * with a submit(std::function<void()>) method such as xss::thread_pool: */
+template <typename T,
+          typename Executor,
+          typename = std::enable_if_t<!std::is_arithmetic_v<Executor>>>
+X86_SIMD_SORT_FINLINE void qsort_parallel(T *arr,
+                                          size_t size,
+                                          Executor &ex,
+                                          bool hasnan = false,
+                                          bool descending = false);
+
 template <typename T>
 X86_SIMD_SORT_FINLINE std::vector<size_t>
 argsort(T *arr, size_t size, bool hasnan = false, bool descending = false);
@@ -45,6 +90,50 @@ template <typename T>
 void X86_SIMD_SORT_FINLINE
 argselect(T *arr, size_t *arg, size_t k, size_t size, bool hasnan = false);
 
+/* argsort/argselect with 32-bit indices, which halves the memory traffic for
+ * the index array. size must fit in 32 bits and arg must hold 0 ... size-1 on
+ * entry, like the NumPy API above: */
+template <typename T>
+X86_SIMD_SORT_FINLINE void argsort(T *arr,
+                                   uint32_t *arg,
+                                   size_t size,
+                                   bool hasnan = false,
+                                   bool descending = false);
+
+template <typename T>
+X86_SIMD_SORT_FINLINE void
+argselect(T *arr, uint32_t *arg, size_t k, size_t size, bool hasnan = false);
+
+/* Multi-threaded argsort/argselect, see qsort_parallel: */
+template <typename T>
+X86_SIMD_SORT_FINLINE std::vector<size_t>
+argsort_parallel(T *arr,
+                 size_t size,
+                 int num_threads = 0,
+                 bool hasnan = false,
+                 bool descending = false);
+
+/* arg is an output buffer of size elements, it need not be initialized */
+template <typename T, typename Executor>
+X86_SIMD_SORT_FINLINE void argsort_parallel(T *arr,
+                                            size_t *arg,
+                                            size_t size,
+                                            Executor &ex,
+                                            bool hasnan = false,
+                                            bool descending = false);
+
+template <typename T>
+X86_SIMD_SORT_FINLINE std::vector<size_t> argselect_parallel(
+        T *arr, size_t k, size_t size, int num_threads = 0, bool hasnan = false);
+
+template <typename T, typename Executor>
+X86_SIMD_SORT_FINLINE void argselect_parallel(T *arr,
+                                              size_t *arg,
+                                              size_t k,
+                                              size_t size,
+                                              Executor &ex,
+                                              bool hasnan = false);
+
 template <typename T1, typename T2>
 X86_SIMD_SORT_FINLINE void keyvalue_qsort(T1 *key,
                                           T2 *val,
@@ -78,6 +167,19 @@ X86_SIMD_SORT_FINLINE void keyvalue_partial_sort(T1 *key,
         ISA##_qsort(arr, size, hasnan, descending); \
     } \
     template <typename T> \
+    X86_SIMD_SORT_FINLINE void x86simdsortStatic::qsort_parallel( \
+            T *arr, size_t size, int num_threads, bool hasnan, bool descending) \
+    { \
+        xss::thread_pool pool(num_threads); \
+        ISA##_qsort_parallel(arr, size, pool, hasnan, descending); \
+    } \
+    template <typename T, typename Executor, typename> \
+    X86_SIMD_SORT_FINLINE void x86simdsortStatic::qsort_parallel( \
+            T *arr, size_t size, Executor &ex, bool hasnan, bool descending) \
+    { \
+        ISA##_qsort_parallel(arr, size, ex, hasnan, descending); \
+    } \
+    template <typename T> \
     X86_SIMD_SORT_FINLINE void x86simdsortStatic::qselect( \
             T *arr, size_t k, size_t size, bool hasnan, bool descending) \
     { \
@@ -90,6 +192,28 @@ X86_SIMD_SORT_FINLINE void keyvalue_partial_sort(T1 *key,
         ISA##_partial_qsort(arr, k, size, hasnan, descending); \
     } \
     template <typename T> \
+    X86_SIMD_SORT_FINLINE void x86simdsortStatic::qsort_segments( \
+            T *arr, \
+            const size_t *offsets, \
+            size_t num_segments, \
+            bool hasnan, \
+            bool descending) \
+    { \
+        ISA##_qsort_segments(arr, offsets, num_segments, hasnan, descending); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_FINLINE size_t x86simdsortStatic::topk_filter( \
+            const T *arr, size_t size, T threshold, T *out, bool descending) \
+    { \
+        return ISA##_topk_filter(arr, size, threshold, out, descending); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_FINLINE void x86simdsortStatic::strided_gather( \
+            const void *base, size_t stride, size_t size, T *out) \
+    { \
+        ISA##_strided_gather(base, stride, size, out); \
+    } \
+    template <typename T> \
     X86_SIMD_SORT_FINLINE void x86simdsortStatic::argsort( \
             T *arr, size_t *arg, size_t size, bool hasnan, bool descending) \
     { \
@@ -112,6 +236,18 @@ X86_SIMD_SORT_FINLINE void keyvalue_partial_sort(T1 *key,
         ISA##_argselect(arr, arg, k, size, hasnan); \
     } \
     template <typename T> \
+    X86_SIMD_SORT_FINLINE void x86simdsortStatic::argsort( \
+            T *arr, uint32_t *arg, size_t size, bool hasnan, bool descending) \
+    { \
+        ISA##_argsort(arr, arg, size, hasnan, descending); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_FINLINE void x86simdsortStatic::argselect( \
+            T *arr, uint32_t *arg, size_t k, size_t size, bool hasnan) \
+    { \
+        ISA##_argselect(arr, arg, k, size, hasnan); \
+    } \
+    template <typename T> \
     X86_SIMD_SORT_FINLINE std::vector<size_t> x86simdsortStatic::argselect( \
             T *arr, size_t k, size_t size, bool hasnan) \
     { \
@@ -120,6 +256,50 @@ X86_SIMD_SORT_FINLINE void keyvalue_partial_sort(T1 *key,
         x86simdsortStatic::argselect(arr, indices.data(), k, size, hasnan); \
         return indices; \
     } \
+    template <typename T, typename Executor> \
+    X86_SIMD_SORT_FINLINE void x86simdsortStatic::argsort_parallel( \
+            T *arr, \
+            size_t *arg, \
+            size_t size, \
+            Executor &ex, \
+            bool hasnan, \
+            bool descending) \
+    { \
+        ISA##_argsort_parallel(arr, arg, size, ex, hasnan, descending); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_FINLINE std::vector<size_t> \
+    x86simdsortStatic::argsort_parallel( \
+            T *arr, size_t size, int num_threads, bool hasnan, bool descending) \
+    { \
+        xss::thread_pool pool(num_threads); \
+        std::vector<size_t> indices(size); \
+        x86simdsortStatic::argsort_parallel( \
+                arr, indices.data(), size, pool, hasnan, descending); \
+        return indices; \
+    } \
+    template <typename T, typename Executor> \
+    X86_SIMD_SORT_FINLINE void x86simdsortStatic::argselect_parallel( \
+            T *arr, \
+            size_t *arg, \
+            size_t k, \
+            size_t size, \
+            Executor &ex, \
+            bool hasnan) \
+    { \
+        ISA##_argselect_parallel(arr, arg, k, size, ex, hasnan); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_FINLINE std::vector<size_t> \
+    x86simdsortStatic::argselect_parallel( \
+            T *arr, size_t k, size_t size, int num_threads, bool hasnan) \
+    { \
+        xss::thread_pool pool(num_threads); \
+        std::vector<size_t> indices(size); \
+        x86simdsortStatic::argselect_parallel( \
+                arr, indices.data(), k, size, pool, hasnan); \
+        return indices; \
+    } \
     template <typename T1, typename T2> \
     X86_SIMD_SORT_FINLINE void x86simdsortStatic::keyvalue_qsort( \
             T1 *key, T2 *val, size_t size, bool hasnan, bool descending) \
@@ -165,6 +345,20 @@ X86_SIMD_SORT_FINLINE void keyvalue_partial_sort(T1 *key,
 /* 16-bit dtypes vector definitions on ICL */
 #if defined(__AVX512BW__) && defined(__AVX512VBMI2__)
 #include "avx512-16bit-qsort.hpp"
+#include "avx512-bf16-qsort.hpp"
+#if defined(__FLT16_MAX__) && !defined(__AVX512FP16__)
+/* _Float16 without AVX512-FP16 is sorted through the 16-bit emulation */
+template <typename executor_t>
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx512_qsort_parallel(_Float16 *arr,
+                      arrsize_t size,
+                      executor_t &ex,
+                      bool hasnan = false,
+                      bool descending = false)
+{
+    avx512_qsort_parallel_fp16((uint16_t *)arr, size, ex, hasnan, descending);
+}
+#endif
 /* _Float16 vector definition on SPR*/
 #if defined(__FLT16_MAX__) && defined(__AVX512BW__) && defined(__AVX512FP16__)
 #include "avx512fp16-16bit-qsort.hpp"
@@ -198,15 +392,159 @@ void x86simdsortStatic::partial_qsort<_Float16>(
 {
     avx512_partial_qsort_fp16((uint16_t *)arr, k, size, hasnan, descending);
 }
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::qsort_segments<_Float16>(_Float16 *arr,
+                                                 const size_t *offsets,
+                                                 size_t num_segments,
+                                                 bool hasnan,
+                                                 bool descending)
+{
+    avx512_qsort_segments_fp16(
+            (uint16_t *)arr, offsets, num_segments, hasnan, descending);
+}
+template <>
+[[maybe_unused]]
+size_t x86simdsortStatic::topk_filter<_Float16>(const _Float16 *arr,
+                                                size_t size,
+                                                _Float16 threshold,
+                                                _Float16 *out,
+                                                bool descending)
+{
+    uint16_t threshold_bits;
+    std::memcpy(&threshold_bits, &threshold, sizeof(threshold));
+    return avx512_topk_filter_fp16((const uint16_t *)arr,
+                                   size,
+                                   threshold_bits,
+                                   (uint16_t *)out,
+                                   descending);
+}
+#endif
+
+#if defined(__BFLT16_MAX__) && defined(__AVX512BW__) \
+        && defined(__AVX512VBMI2__)
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::qsort<__bf16>(__bf16 *arr,
+                                      size_t size,
+                                      bool hasnan,
+                                      bool descending)
+{
+    avx512_qsort_bf16((uint16_t *)arr, size, hasnan, descending);
+}
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::qselect<__bf16>(
+        __bf16 *arr, size_t k, size_t size, bool hasnan, bool descending)
+{
+    avx512_qselect_bf16((uint16_t *)arr, k, size, hasnan, descending);
+}
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::partial_qsort<__bf16>(
+        __bf16 *arr, size_t k, size_t size, bool hasnan, bool descending)
+{
+    avx512_partial_qsort_bf16((uint16_t *)arr, k, size, hasnan, descending);
+}
 #endif
 
 #elif defined(__AVX2__)
-/* 32-bit and 64-bit dtypes vector definitions on AVX2 */
+/* 16-bit, 32-bit and 64-bit dtypes vector definitions on AVX2 */
+#include "avx2-16bit-qsort.hpp"
 #include "avx2-32bit-half.hpp"
 #include "avx2-32bit-qsort.hpp"
 #include "avx2-64bit-qsort.hpp"
+#ifdef __FLT16_MAX__
+/* _Float16 is sorted as ordered 16-bit integers, see avx2-16bit-qsort.hpp */
+template <typename executor_t>
+[[maybe_unused]] X86_SIMD_SORT_INLINE void
+avx2_qsort_parallel(_Float16 *arr,
+                    arrsize_t size,
+                    executor_t &ex,
+                    bool hasnan = false,
+                    bool descending = false)
+{
+    UNUSED(hasnan);
+    avx2_qsort_parallel_ordered<avx2_fp16_ordered>(
+            (uint16_t *)arr, size, ex, descending);
+}
+#endif
 XSS_METHODS(avx2)
 
+#ifdef __FLT16_MAX__
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::qsort<_Float16>(_Float16 *arr,
+                                        size_t size,
+                                        bool hasnan,
+                                        bool descending)
+{
+    UNUSED(hasnan);
+    avx2_qsort_ordered<avx2_fp16_ordered>((uint16_t *)arr, size, descending);
+}
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::qselect<_Float16>(
+        _Float16 *arr, size_t k, size_t size, bool hasnan, bool descending)
+{
+    UNUSED(hasnan);
+    avx2_qselect_ordered<avx2_fp16_ordered>(
+            (uint16_t *)arr, k, size, descending);
+}
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::partial_qsort<_Float16>(
+        _Float16 *arr, size_t k, size_t size, bool hasnan, bool descending)
+{
+    UNUSED(hasnan);
+    avx2_partial_qsort_ordered<avx2_fp16_ordered>(
+            (uint16_t *)arr, k, size, descending);
+}
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::qsort_segments<_Float16>(_Float16 *arr,
+                                                 const size_t *offsets,
+                                                 size_t num_segments,
+                                                 bool hasnan,
+                                                 bool descending)
+{
+    UNUSED(hasnan);
+    avx2_qsort_segments_ordered<avx2_fp16_ordered>(
+            (uint16_t *)arr, offsets, num_segments, descending);
+}
+#endif
+
+#ifdef __BFLT16_MAX__
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::qsort<__bf16>(__bf16 *arr,
+                                      size_t size,
+                                      bool hasnan,
+                                      bool descending)
+{
+    UNUSED(hasnan);
+    avx2_qsort_ordered<avx2_bf16_ordered>((uint16_t *)arr, size, descending);
+}
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::qselect<__bf16>(
+        __bf16 *arr, size_t k, size_t size, bool hasnan, bool descending)
+{
+    UNUSED(hasnan);
+    avx2_qselect_ordered<avx2_bf16_ordered>(
+            (uint16_t *)arr, k, size, descending);
+}
+template <>
+[[maybe_unused]]
+void x86simdsortStatic::partial_qsort<__bf16>(
+        __bf16 *arr, size_t k, size_t size, bool hasnan, bool descending)
+{
+    UNUSED(hasnan);
+    avx2_partial_qsort_ordered<avx2_bf16_ordered>(
+            (uint16_t *)arr, k, size, descending);
+}
+#endif
+
 #else
 #error "x86simdsortStatic methods needs to be compiled with avx512/avx2 specific flags"
 #endif // (__AVX512VL__ && __AVX512DQ__) || AVX2
@@ -8,16 +8,18 @@
 #define XSS_COMMON_ARGSORT
 
 #include "xss-network-keyvaluesort.hpp"
+#include "xss-thread-pool.hpp"
+#include "xss-widen-16bit.hpp"
 #include <numeric>
 
-template <typename T>
+template <typename T, typename arg_t>
 X86_SIMD_SORT_INLINE void std_argselect_withnan(
-        T *arr, arrsize_t *arg, arrsize_t k, arrsize_t left, arrsize_t right)
+        T *arr, arg_t *arg, arrsize_t k, arrsize_t left, arrsize_t right)
 {
     std::nth_element(arg + left,
                      arg + k,
                      arg + right,
-                     [arr](arrsize_t a, arrsize_t b) -> bool {
+                     [arr](arg_t a, arg_t b) -> bool {
                          if ((!std::isnan(arr[a])) && (!std::isnan(arr[b]))) {
                              return arr[a] < arr[b];
                          }
@@ -31,13 +33,13 @@ X86_SIMD_SORT_INLINE void std_argselect_withnan(
 }
 
 /* argsort using std::sort */
-template <typename T>
+template <typename T, typename arg_t>
 X86_SIMD_SORT_INLINE void
-std_argsort_withnan(T *arr, arrsize_t *arg, arrsize_t left, arrsize_t right)
+std_argsort_withnan(T *arr, arg_t *arg, arrsize_t left, arrsize_t right)
 {
     std::sort(arg + left,
               arg + right,
-              [arr](arrsize_t left, arrsize_t right) -> bool {
+              [arr](arg_t left, arg_t right) -> bool {
                   if ((!std::isnan(arr[left])) && (!std::isnan(arr[right]))) {
                       return arr[left] < arr[right];
                   }
@@ -51,13 +53,13 @@ std_argsort_withnan(T *arr, arrsize_t *arg, arrsize_t left, arrsize_t right)
 }
 
 /* argsort using std::sort */
-template <typename T>
+template <typename T, typename arg_t>
 X86_SIMD_SORT_INLINE void
-std_argsort(T *arr, arrsize_t *arg, arrsize_t left, arrsize_t right)
+std_argsort(T *arr, arg_t *arg, arrsize_t left, arrsize_t right)
 {
     std::sort(arg + left,
               arg + right,
-              [arr](arrsize_t left, arrsize_t right) -> bool {
+              [arr](arg_t left, arg_t right) -> bool {
                   // sort indices according to corresponding array element
                   return arr[left] < arr[right];
               });
@@ -171,9 +173,9 @@ X86_SIMD_SORT_INLINE int32_t partition_vec(type_t *arg,
  * Parition an array based on the pivot and returns the index of the
  * last element that is less than equal to the pivot.
  */
-template <typename vtype, typename argtype, typename type_t>
+template <typename vtype, typename argtype, typename type_t, typename arg_t>
 X86_SIMD_SORT_INLINE arrsize_t argpartition(type_t *arr,
-                                            arrsize_t *arg,
+                                            arg_t *arg,
                                             arrsize_t left,
                                             arrsize_t right,
                                             type_t pivot,
@@ -203,7 +205,7 @@ X86_SIMD_SORT_INLINE arrsize_t argpartition(type_t *arr,
 
     if (right - left == vtype::numlanes) {
         argreg_t argvec = argtype::loadu(arg + left);
-        reg_t vec = vtype::i64gather(arr, arg + left);
+        reg_t vec = arg_gather<vtype, argtype>(arr, arg + left, argvec);
         int32_t amount_gt_pivot
                 = partition_vec<vtype, argtype>(arg,
                                                 left,
@@ -220,9 +222,10 @@ X86_SIMD_SORT_INLINE arrsize_t argpartition(type_t *arr,
 
     // first and last vtype::numlanes values are partitioned at the end
     argreg_t argvec_left = argtype::loadu(arg + left);
-    reg_t vec_left = vtype::i64gather(arr, arg + left);
+    reg_t vec_left = arg_gather<vtype, argtype>(arr, arg + left, argvec_left);
     argreg_t argvec_right = argtype::loadu(arg + (right - vtype::numlanes));
-    reg_t vec_right = vtype::i64gather(arr, arg + (right - vtype::numlanes));
+    reg_t vec_right = arg_gather<vtype, argtype>(
+            arr, arg + (right - vtype::numlanes), argvec_right);
     // store points of the vectors
     arrsize_t r_store = right - vtype::numlanes;
     arrsize_t l_store = left;
@@ -240,11 +243,11 @@ X86_SIMD_SORT_INLINE arrsize_t argpartition(type_t *arr,
         if ((r_store + vtype::numlanes) - right < left - l_store) {
             right -= vtype::numlanes;
             arg_vec = argtype::loadu(arg + right);
-            curr_vec = vtype::i64gather(arr, arg + right);
+            curr_vec = arg_gather<vtype, argtype>(arr, arg + right, arg_vec);
         }
         else {
             arg_vec = argtype::loadu(arg + left);
-            curr_vec = vtype::i64gather(arr, arg + left);
+            curr_vec = arg_gather<vtype, argtype>(arr, arg + left, arg_vec);
             left += vtype::numlanes;
         }
         // partition the current vector and save it on both sides of the array
@@ -290,9 +293,10 @@ X86_SIMD_SORT_INLINE arrsize_t argpartition(type_t *arr,
 template <typename vtype,
           typename argtype,
           int num_unroll,
-          typename type_t = typename vtype::type_t>
+          typename type_t = typename vtype::type_t,
+          typename arg_t = arrsize_t>
 X86_SIMD_SORT_INLINE arrsize_t argpartition_unrolled(type_t *arr,
-                                                     arrsize_t *arg,
+                                                     arg_t *arg,
                                                      arrsize_t left,
                                                      arrsize_t right,
                                                      type_t pivot,
@@ -331,11 +335,14 @@ X86_SIMD_SORT_INLINE arrsize_t argpartition_unrolled(type_t *arr,
     X86_SIMD_SORT_UNROLL_LOOP(8)
     for (int ii = 0; ii < num_unroll; ++ii) {
         argvec_left[ii] = argtype::loadu(arg + left + vtype::numlanes * ii);
-        vec_left[ii] = vtype::i64gather(arr, arg + left + vtype::numlanes * ii);
+        vec_left[ii] = arg_gather<vtype, argtype>(
+                arr, arg + left + vtype::numlanes * ii, argvec_left[ii]);
         argvec_right[ii] = argtype::loadu(
                 arg + (right - vtype::numlanes * (num_unroll - ii)));
-        vec_right[ii] = vtype::i64gather(
-                arr, arg + (right - vtype::numlanes * (num_unroll - ii)));
+        vec_right[ii] = arg_gather<vtype, argtype>(
+                arr,
+                arg + (right - vtype::numlanes * (num_unroll - ii)),
+                argvec_right[ii]);
     }
     // store points of the vectors
     arrsize_t r_store = right - vtype::numlanes;
@@ -357,16 +364,16 @@ X86_SIMD_SORT_INLINE arrsize_t argpartition_unrolled(type_t *arr,
             for (int ii = 0; ii < num_unroll; ++ii) {
                 arg_vec[ii]
                         = argtype::loadu(arg + right + ii * vtype::numlanes);
-                curr_vec[ii] = vtype::i64gather(
-                        arr, arg + right + ii * vtype::numlanes);
+                curr_vec[ii] = arg_gather<vtype, argtype>(
+                        arr, arg + right + ii * vtype::numlanes, arg_vec[ii]);
             }
         }
         else {
             X86_SIMD_SORT_UNROLL_LOOP(8)
             for (int ii = 0; ii < num_unroll; ++ii) {
                 arg_vec[ii] = argtype::loadu(arg + left + ii * vtype::numlanes);
-                curr_vec[ii] = vtype::i64gather(
-                        arr, arg + left + ii * vtype::numlanes);
+                curr_vec[ii] = arg_gather<vtype, argtype>(
+                        arr, arg + left + ii * vtype::numlanes, arg_vec[ii]);
             }
             left += num_unroll * vtype::numlanes;
         }
@@ -421,55 +428,32 @@ X86_SIMD_SORT_INLINE arrsize_t argpartition_unrolled(type_t *arr,
     return l_store;
 }
 
-template <typename vtype, typename type_t>
+template <typename vtype, typename type_t, typename arg_t>
 X86_SIMD_SORT_INLINE type_t get_pivot_64bit(type_t *arr,
-                                            arrsize_t *arg,
+                                            arg_t *arg,
                                             const arrsize_t left,
                                             const arrsize_t right)
 {
-    if constexpr (vtype::numlanes == 8) {
-        if (right - left >= vtype::numlanes) {
-            // median of 8
-            arrsize_t size = (right - left) / 8;
-            using reg_t = typename vtype::reg_t;
-            reg_t rand_vec = vtype::set(arr[arg[left + size]],
-                                        arr[arg[left + 2 * size]],
-                                        arr[arg[left + 3 * size]],
-                                        arr[arg[left + 4 * size]],
-                                        arr[arg[left + 5 * size]],
-                                        arr[arg[left + 6 * size]],
-                                        arr[arg[left + 7 * size]],
-                                        arr[arg[left + 8 * size]]);
-            // pivot will never be a nan, since there are no nan's!
-            reg_t sort = vtype::sort_vec(rand_vec);
-            return ((type_t *)&sort)[4];
-        }
-        else {
-            return arr[arg[right]];
+    if (right - left >= vtype::numlanes) {
+        // median of vtype::numlanes
+        arrsize_t size = (right - left) / vtype::numlanes;
+        type_t samples[vtype::numlanes];
+        for (int i = 0; i < vtype::numlanes; ++i) {
+            samples[i] = arr[arg[left + (i + 1) * size]];
         }
+        using reg_t = typename vtype::reg_t;
+        // pivot will never be a nan, since there are no nan's!
+        reg_t sort = vtype::sort_vec(vtype::loadu(samples));
+        return ((type_t *)&sort)[vtype::numlanes / 2];
     }
-    else if constexpr (vtype::numlanes == 4) {
-        if (right - left >= vtype::numlanes) {
-            // median of 4
-            arrsize_t size = (right - left) / 4;
-            using reg_t = typename vtype::reg_t;
-            reg_t rand_vec = vtype::set(arr[arg[left + size]],
-                                        arr[arg[left + 2 * size]],
-                                        arr[arg[left + 3 * size]],
-                                        arr[arg[left + 4 * size]]);
-            // pivot will never be a nan, since there are no nan's!
-            reg_t sort = vtype::sort_vec(rand_vec);
-            return ((type_t *)&sort)[2];
-        }
-        else {
-            return arr[arg[right]];
-        }
+    else {
+        return arr[arg[right]];
     }
 }
 
-template <typename vtype, typename argtype, typename type_t>
+template <typename vtype, typename argtype, typename type_t, typename arg_t>
 X86_SIMD_SORT_INLINE void argsort_(type_t *arr,
-                                   arrsize_t *arg,
+                                   arg_t *arg,
                                    arrsize_t left,
                                    arrsize_t right,
                                    arrsize_t max_iters,
@@ -548,9 +532,81 @@ X86_SIMD_SORT_INLINE void argsort_(type_t *arr,
 #endif
 }
 
-template <typename vtype, typename argtype, typename type_t>
+/*
+ * Parallel version of argsort_: sub-arrays above task_threshold are sorted as
+ * separate jobs on the executor, the current thread continues with the right
+ * half (see qsort_parallel_ in xss-common-qsort.h).
+ */
+template <typename vtype,
+          typename argtype,
+          typename type_t,
+          typename executor_t>
+static void argsort_parallel_(type_t *arr,
+                              arrsize_t *arg,
+                              arrsize_t left,
+                              arrsize_t right,
+                              arrsize_t max_iters,
+                              arrsize_t task_threshold,
+                              xss::task_group<executor_t> &tasks)
+{
+    while (right + 1 - left > task_threshold) {
+        if (max_iters <= 0) {
+            std_argsort(arr, arg, left, right + 1);
+            return;
+        }
+        type_t pivot = get_pivot_64bit<vtype>(arr, arg, left, right);
+        type_t smallest = vtype::type_max();
+        type_t biggest = vtype::type_min();
+        arrsize_t pivot_index = argpartition_unrolled<vtype, argtype, 4>(
+                arr, arg, left, right + 1, pivot, &smallest, &biggest);
+        if (pivot != smallest) {
+            arrsize_t sub_right = pivot_index - 1;
+            tasks.run([=, &tasks]() {
+                argsort_parallel_<vtype, argtype>(arr,
+                                                  arg,
+                                                  left,
+                                                  sub_right,
+                                                  max_iters - 1,
+                                                  task_threshold,
+                                                  tasks);
+            });
+        }
+        if (pivot == biggest) { return; }
+        left = pivot_index;
+        max_iters = max_iters - 1;
+    }
+    argsort_<vtype, argtype>(arr,
+                             arg,
+                             left,
+                             right,
+                             max_iters,
+                             std::numeric_limits<arrsize_t>::max());
+}
+
+/*
+ * Writes arg[i] = i with one job per block of indices, so that the pages of a
+ * freshly allocated index array are first touched by the worker threads.
+ */
+template <typename executor_t>
+X86_SIMD_SORT_INLINE void
+xss_iota_parallel(arrsize_t *arg, arrsize_t arrsize, executor_t &ex)
+{
+    constexpr arrsize_t block = 1 << 16;
+    if (arrsize <= block) {
+        std::iota(arg, arg + arrsize, 0);
+        return;
+    }
+    xss::task_group<executor_t> tasks(ex);
+    for (arrsize_t start = 0; start < arrsize; start += block) {
+        arrsize_t end = std::min(arrsize, start + block);
+        tasks.run([=]() { std::iota(arg + start, arg + end, start); });
+    }
+    tasks.wait();
+}
+
+template <typename vtype, typename argtype, typename type_t, typename arg_t>
 X86_SIMD_SORT_INLINE void argselect_(type_t *arr,
-                                     arrsize_t *arg,
+                                     arg_t *arg,
                                      arrsize_t pos,
                                      arrsize_t left,
                                      arrsize_t right,
@@ -584,27 +640,29 @@ X86_SIMD_SORT_INLINE void argselect_(type_t *arr,
                 arr, arg, pos, pivot_index, right, max_iters - 1);
 }
 
-/* argsort methods for 32-bit and 64-bit dtypes */
+/* argsort methods for 32-bit and 64-bit dtypes, with 32-bit or 64-bit
+ * indices */
 template <typename T,
           template <typename...>
           typename full_vector,
           template <typename...>
-          typename half_vector>
+          typename half_vector,
+          typename arg_t>
 X86_SIMD_SORT_INLINE void xss_argsort(T *arr,
-                                      arrsize_t *arg,
+                                      arg_t *arg,
                                       arrsize_t arrsize,
                                       bool hasnan = false,
                                       bool descending = false)
 {
-
-    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+    /* keys and indices need the same number of lanes, so the narrower of the
+     * two lives in a half vector */
+    using vectype = typename std::conditional<(sizeof(T) < sizeof(arg_t)),
                                               half_vector<T>,
                                               full_vector<T>>::type;
 
-    using argtype =
-            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
-                                      half_vector<arrsize_t>,
-                                      full_vector<arrsize_t>>::type;
+    using argtype = typename std::conditional<(sizeof(arg_t) < sizeof(T)),
+                                              half_vector<arg_t>,
+                                              full_vector<arg_t>>::type;
 
     if (arrsize > 1) {
         /* simdargsort does not work for float/double arrays with nan */
@@ -624,6 +682,15 @@ X86_SIMD_SORT_INLINE void xss_argsort(T *arr,
                                : Comparator<vectype, false>::STDSortComparator;
         if (std::is_sorted(arr, arr + arrsize, comp)) { return; }
 
+        /* the gathers treat 32-bit indices as signed */
+        if constexpr (sizeof(arg_t) == sizeof(int32_t)) {
+            if (arrsize > (arrsize_t)std::numeric_limits<int32_t>::max()) {
+                std_argsort(arr, arg, 0, arrsize);
+                if (descending) { std::reverse(arg, arg + arrsize); }
+                return;
+            }
+        }
+
 #ifdef XSS_COMPILE_OPENMP
 
         bool use_parallel = arrsize > 10000;
@@ -668,41 +735,59 @@ X86_SIMD_SORT_INLINE void xss_argsort(T *arr,
 #endif
 }
 
-template <typename T>
+/*
+ * 16-bit dtypes are arg-sorted on a copy of the keys widened to 32 bits, see
+ * xss-widen-16bit.hpp
+ */
+template <typename T, typename arg_t>
 X86_SIMD_SORT_INLINE void avx512_argsort(T *arr,
-                                         arrsize_t *arg,
+                                         arg_t *arg,
                                          arrsize_t arrsize,
                                          bool hasnan = false,
                                          bool descending = false)
 {
-    xss_argsort<T, zmm_vector, ymm_vector>(
-            arr, arg, arrsize, hasnan, descending);
+    if constexpr (sizeof(T) == sizeof(int16_t)) {
+        auto keys = xss_widen_16bit(arr, arrsize);
+        avx512_argsort(keys.get(), arg, arrsize, hasnan, descending);
+    }
+    else {
+        xss_argsort<T, zmm_vector, ymm_vector>(
+                arr, arg, arrsize, hasnan, descending);
+    }
 }
 
-template <typename T>
+template <typename T, typename arg_t>
 X86_SIMD_SORT_INLINE void avx2_argsort(T *arr,
-                                       arrsize_t *arg,
+                                       arg_t *arg,
                                        arrsize_t arrsize,
                                        bool hasnan = false,
                                        bool descending = false)
 {
-    xss_argsort<T, avx2_vector, avx2_half_vector>(
-            arr, arg, arrsize, hasnan, descending);
+    if constexpr (sizeof(T) == sizeof(int16_t)) {
+        auto keys = xss_widen_16bit(arr, arrsize);
+        avx2_argsort(keys.get(), arg, arrsize, hasnan, descending);
+    }
+    else {
+        xss_argsort<T, avx2_vector, avx2_half_vector>(
+                arr, arg, arrsize, hasnan, descending);
+    }
 }
 
-/* argselect methods for 32-bit and 64-bit dtypes */
+/* Multi-threaded argsort for 32-bit and 64-bit dtypes: arg is an output
+ * buffer of arrsize elements and is filled with the indices in parallel */
 template <typename T,
           template <typename...>
           typename full_vector,
           template <typename...>
-          typename half_vector>
-X86_SIMD_SORT_INLINE void xss_argselect(T *arr,
-                                        arrsize_t *arg,
-                                        arrsize_t k,
-                                        arrsize_t arrsize,
-                                        bool hasnan = false)
+          typename half_vector,
+          typename executor_t>
+X86_SIMD_SORT_INLINE void xss_argsort_parallel(T *arr,
+                                               arrsize_t *arg,
+                                               arrsize_t arrsize,
+                                               executor_t &ex,
+                                               bool hasnan = false,
+                                               bool descending = false)
 {
-    /* TODO optimization: on 32-bit, use full_vector for 32-bit dtype */
     using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
                                               half_vector<T>,
                                               full_vector<T>>::type;
@@ -712,6 +797,115 @@ X86_SIMD_SORT_INLINE void xss_argselect(T *arr,
                                       half_vector<arrsize_t>,
                                       full_vector<arrsize_t>>::type;
 
+    xss_iota_parallel(arg, arrsize, ex);
+
+    if (arrsize > 1) {
+        /* simdargsort does not work for float/double arrays with nan */
+        if constexpr (xss::fp::is_floating_point_v<T>) {
+            if ((hasnan) && (array_has_nan<vectype>(arr, arrsize))) {
+                std_argsort_withnan(arr, arg, 0, arrsize);
+
+                if (descending) { std::reverse(arg, arg + arrsize); }
+
+                return;
+            }
+        }
+        UNUSED(hasnan);
+
+        /* early exit for already sorted arrays: float/double with nan never reach here*/
+        auto comp = descending ? Comparator<vectype, true>::STDSortComparator
+                               : Comparator<vectype, false>::STDSortComparator;
+        if (std::is_sorted(arr, arr + arrsize, comp)) { return; }
+
+        arrsize_t max_iters = 2 * (arrsize_t)log2(arrsize);
+        if (arrsize > 10000) {
+            arrsize_t task_threshold
+                    = std::max((arrsize_t)10000, arrsize / 100);
+            xss::task_group<executor_t> tasks(ex);
+            argsort_parallel_<vectype, argtype>(
+                    arr, arg, 0, arrsize - 1, max_iters, task_threshold, tasks);
+            tasks.wait();
+        }
+        else {
+            argsort_<vectype, argtype>(arr,
+                                       arg,
+                                       0,
+                                       arrsize - 1,
+                                       max_iters,
+                                       std::numeric_limits<arrsize_t>::max());
+        }
+
+        if (descending) { std::reverse(arg, arg + arrsize); }
+    }
+
+#ifdef __MMX__
+    // Workaround for compiler bug generating MMX instructions without emms
+    _mm_empty();
+#endif
+}
+
+template <typename T, typename executor_t>
+X86_SIMD_SORT_INLINE void avx512_argsort_parallel(T *arr,
+                                                  arrsize_t *arg,
+                                                  arrsize_t arrsize,
+                                                  executor_t &ex,
+                                                  bool hasnan = false,
+                                                  bool descending = false)
+{
+    if constexpr (sizeof(T) == sizeof(int16_t)) {
+        auto keys = xss_widen_16bit(arr, arrsize);
+        avx512_argsort_parallel(
+                keys.get(), arg, arrsize, ex, hasnan, descending);
+    }
+    else {
+        xss_argsort_parallel<T, zmm_vector, ymm_vector>(
+                arr, arg, arrsize, ex, hasnan, descending);
+    }
+}
+
+template <typename T, typename executor_t>
+X86_SIMD_SORT_INLINE void avx2_argsort_parallel(T *arr,
+                                                arrsize_t *arg,
+                                                arrsize_t arrsize,
+                                                executor_t &ex,
+                                                bool hasnan = false,
+                                                bool descending = false)
+{
+    if constexpr (sizeof(T) == sizeof(int16_t)) {
+        auto keys = xss_widen_16bit(arr, arrsize);
+        avx2_argsort_parallel(
+                keys.get(), arg, arrsize, ex, hasnan, descending);
+    }
+    else {
+        xss_argsort_parallel<T, avx2_vector, avx2_half_vector>(
+                arr, arg, arrsize, ex, hasnan, descending);
+    }
+}
+
+/* argselect methods for 32-bit and 64-bit dtypes, with 32-bit or 64-bit
+ * indices */
+template <typename T,
+          template <typename...>
+          typename full_vector,
+          template <typename...>
+          typename half_vector,
+          typename arg_t>
+X86_SIMD_SORT_INLINE void xss_argselect(T *arr,
+                                        arg_t *arg,
+                                        arrsize_t k,
+                                        arrsize_t arrsize,
+                                        bool hasnan = false)
+{
+    /* keys and indices need the same number of lanes, so the narrower of the
+     * two lives in a half vector */
+    using vectype = typename std::conditional<(sizeof(T) < sizeof(arg_t)),
+                                              half_vector<T>,
+                                              full_vector<T>>::type;
+
+    using argtype = typename std::conditional<(sizeof(arg_t) < sizeof(T)),
+                                              half_vector<arg_t>,
+                                              full_vector<arg_t>>::type;
+
     if (arrsize > 1) {
         if constexpr (xss::fp::is_floating_point_v<T>) {
             if ((hasnan) && (array_has_nan<vectype>(arr, arrsize))) {
@@ -720,6 +914,18 @@ X86_SIMD_SORT_INLINE void xss_argselect(T *arr,
             }
         }
         UNUSED(hasnan);
+        /* the gathers treat 32-bit indices as signed */
+        if constexpr (sizeof(arg_t) == sizeof(int32_t)) {
+            if (arrsize > (arrsize_t)std::numeric_limits<int32_t>::max()) {
+                std::nth_element(arg,
+                                 arg + k,
+                                 arg + arrsize,
+                                 [arr](arg_t a, arg_t b) -> bool {
+                                     return arr[a] < arr[b];
+                                 });
+                return;
+            }
+        }
         argselect_<vectype, argtype>(
                 arr, arg, k, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
     }
@@ -730,25 +936,131 @@ X86_SIMD_SORT_INLINE void xss_argselect(T *arr,
 #endif
 }
 
-template <typename T>
+template <typename T, typename arg_t>
 X86_SIMD_SORT_INLINE void avx512_argselect(T *arr,
-                                           arrsize_t *arg,
+                                           arg_t *arg,
                                            arrsize_t k,
                                            arrsize_t arrsize,
                                            bool hasnan = false)
 {
-    xss_argselect<T, zmm_vector, ymm_vector>(arr, arg, k, arrsize, hasnan);
+    if constexpr (sizeof(T) == sizeof(int16_t)) {
+        auto keys = xss_widen_16bit(arr, arrsize);
+        avx512_argselect(keys.get(), arg, k, arrsize, hasnan);
+    }
+    else {
+        xss_argselect<T, zmm_vector, ymm_vector>(arr, arg, k, arrsize, hasnan);
+    }
 }
 
-template <typename T>
+template <typename T, typename arg_t>
 X86_SIMD_SORT_INLINE void avx2_argselect(T *arr,
-                                         arrsize_t *arg,
+                                         arg_t *arg,
                                          arrsize_t k,
                                          arrsize_t arrsize,
                                          bool hasnan = false)
 {
-    xss_argselect<T, avx2_vector, avx2_half_vector>(
-            arr, arg, k, arrsize, hasnan);
+    if constexpr (sizeof(T) == sizeof(int16_t)) {
+        auto keys = xss_widen_16bit(arr, arrsize);
+        avx2_argselect(keys.get(), arg, k, arrsize, hasnan);
+    }
+    else {
+        xss_argselect<T, avx2_vector, avx2_half_vector>(
+                arr, arg, k, arrsize, hasnan);
+    }
+}
+
+/* argselect only ever recurses into one side of the partition, so the parallel
+ * variant differs from xss_argselect in filling the index array in parallel */
+template <typename T, typename executor_t>
+X86_SIMD_SORT_INLINE void avx512_argselect_parallel(T *arr,
+                                                    arrsize_t *arg,
+                                                    arrsize_t k,
+                                                    arrsize_t arrsize,
+                                                    executor_t &ex,
+                                                    bool hasnan = false)
+{
+    xss_iota_parallel(arg, arrsize, ex);
+    avx512_argselect(arr, arg, k, arrsize, hasnan);
+}
+
+template <typename T, typename executor_t>
+X86_SIMD_SORT_INLINE void avx2_argselect_parallel(T *arr,
+                                                  arrsize_t *arg,
+                                                  arrsize_t k,
+                                                  arrsize_t arrsize,
+                                                  executor_t &ex,
+                                                  bool hasnan = false)
+{
+    xss_iota_parallel(arg, arrsize, ex);
+    avx2_argselect(arr, arg, k, arrsize, hasnan);
+}
+
+/*
+ * Copies the T found ii * stride bytes past base to out[ii], e.g. one member
+ * of every element of an array of structs, with one hardware gather per
+ * register. The gathers take signed 32-bit byte offsets relative to the first
+ * element of the register, so strides too large for those are copied element
+ * by element.
+ */
+template <typename T,
+          template <typename...>
+          typename full_vector,
+          template <typename...>
+          typename half_vector>
+X86_SIMD_SORT_INLINE void xss_strided_gather(const void *base,
+                                             arrsize_t stride,
+                                             arrsize_t arrsize,
+                                             T *out)
+{
+    using vtype = full_vector<T>;
+    using offtype = typename std::conditional<(sizeof(uint32_t) < sizeof(T)),
+                                              half_vector<uint32_t>,
+                                              full_vector<uint32_t>>::type;
+    const char *src = (const char *)base;
+    arrsize_t ii = 0;
+    if (stride * vtype::numlanes
+        <= (arrsize_t)std::numeric_limits<int32_t>::max()) {
+        uint32_t offsets[vtype::numlanes];
+        for (int jj = 0; jj < vtype::numlanes; ++jj) {
+            offsets[jj] = jj * stride;
+        }
+        auto offset_vec = offtype::loadu(offsets);
+        auto mask = vtype::get_partial_loadmask(vtype::numlanes);
+        for (; ii + vtype::numlanes <= arrsize; ii += vtype::numlanes) {
+            vtype::storeu(out + ii,
+                          vtype::template mask_i64gather<1>(vtype::zmm_max(),
+                                                            mask,
+                                                            offset_vec,
+                                                            src + ii * stride));
+        }
+    }
+    for (; ii < arrsize; ++ii) {
+        std::memcpy(out + ii, src + ii * stride, sizeof(T));
+    }
+
+#ifdef __MMX__
+    // Workaround for compiler bug generating MMX instructions without emms
+    _mm_empty();
+#endif
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void avx512_strided_gather(const void *base,
+                                                arrsize_t stride,
+                                                arrsize_t arrsize,
+                                                T *out)
+{
+    xss_strided_gather<T, zmm_vector, ymm_vector>(base, stride, arrsize, out);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void avx2_strided_gather(const void *base,
+                                              arrsize_t stride,
+                                              arrsize_t arrsize,
+                                              T *out)
+{
+    xss_strided_gather<T, avx2_vector, avx2_half_vector>(
+            base, stride, arrsize, out);
 }
 
 #endif // XSS_COMMON_ARGSORT
@@ -40,6 +40,8 @@ struct Comparator {
     using opmask_t = typename vtype::opmask_t;
     using type_t = typename vtype::type_t;
 
+    static constexpr bool is_descending = descend;
+
     X86_SIMD_SORT_FINLINE bool STDSortComparator(const type_t &a,
                                                  const type_t &b)
     {
@@ -10,6 +10,7 @@
 
 #include "xss-common-qsort.h"
 #include "xss-network-keyvaluesort.hpp"
+#include "xss-widen-16bit.hpp"
 
 /*
  * Sort all the NAN's to end of the array and return the index of the last elem
@@ -68,12 +69,55 @@ X86_SIMD_SORT_INLINE arrsize_t move_nans_to_end_of_array(T1 *keys,
     return size - count - 1;
 }
 
+/*
+ * Sort all the NAN's to start of the array and return the index of the first
+ * elem in the array which is not a nan
+ */
+template <typename T1, typename T2, typename vtype>
+X86_SIMD_SORT_INLINE arrsize_t move_nans_to_start_of_array(T1 *keys,
+                                                           T2 *vals,
+                                                           arrsize_t size)
+{
+    using reg_t = typename vtype::reg_t;
+
+    arrsize_t count = 0;
+    arrsize_t i = 0;
+
+    for (; i + vtype::numlanes <= size; i += vtype::numlanes) {
+        reg_t in = vtype::loadu(keys + i);
+        auto nanmask = vtype::convert_mask_to_int(
+                vtype::template fpclass<0x01 | 0x80>(in));
+
+        // Only vectors with nans in them are processed one by one
+        if (nanmask == 0x00) { continue; }
+        for (arrsize_t j = i; j < i + vtype::numlanes; j++) {
+            if (is_a_nan(keys[j])) {
+                std::swap(keys[count], keys[j]);
+                std::swap(vals[count], vals[j]);
+                count++;
+            }
+        }
+    }
+
+    for (; i < size; i++) {
+        if (is_a_nan(keys[i])) {
+            std::swap(keys[count], keys[i]);
+            std::swap(vals[count], vals[i]);
+            count++;
+        }
+    }
+
+    return count;
+}
+
 /*
  * Parition one ZMM register based on the pivot and returns the index of the
  * last element that is less than equal to the pivot.
  */
 template <typename vtype1,
           typename vtype2,
+          typename comparator,
+          nan_mode_t nan_mode = nan_mode_t::none,
           typename type_t1 = typename vtype1::type_t,
           typename type_t2 = typename vtype2::type_t,
           typename reg_t1 = typename vtype1::reg_t,
@@ -86,10 +130,25 @@ X86_SIMD_SORT_INLINE int32_t partition_vec(type_t1 *keys,
                                            const reg_t2 indexes_vec,
                                            const reg_t1 pivot_vec,
                                            reg_t1 *smallest_vec,
-                                           reg_t1 *biggest_vec)
+                                           reg_t1 *biggest_vec,
+                                           arrsize_t *nan_count = nullptr)
 {
-    /* which elements are larger than the pivot */
-    typename vtype1::opmask_t gt_mask = vtype1::ge(keys_vec, pivot_vec);
+    // The values move with the keys, so NaN keys can only be routed
+    static_assert(nan_mode != nan_mode_t::replace);
+    reg_t1 cmp_vec = keys_vec;
+    reg_t1 key_vec = keys_vec;
+    if constexpr (nan_mode == nan_mode_t::route) {
+        auto nanmask = vtype1::template fpclass<0x01 | 0x80>(keys_vec);
+        *nan_count += _mm_popcnt_u32(vtype1::convert_mask_to_int(nanmask));
+        key_vec = vtype1::mask_mov(keys_vec, nanmask, vtype1::zmm_max());
+        // NaNs fail every compare, which leaves them left of the pivot
+        if constexpr (!comparator::is_descending) { cmp_vec = key_vec; }
+    }
+    UNUSED(nan_count);
+
+    /* which elements go to the right of the pivot */
+    typename vtype1::opmask_t gt_mask
+            = comparator::PartitionComparator(cmp_vec, pivot_vec);
 
     int32_t amount_gt_pivot = vtype1::double_compressstore(
             keys + left, keys + right - vtype1::numlanes, gt_mask, keys_vec);
@@ -98,16 +157,61 @@ X86_SIMD_SORT_INLINE int32_t partition_vec(type_t1 *keys,
                                  resize_mask<vtype1, vtype2>(gt_mask),
                                  indexes_vec);
 
-    *smallest_vec = vtype1::min(keys_vec, *smallest_vec);
-    *biggest_vec = vtype1::max(keys_vec, *biggest_vec);
+    *smallest_vec = vtype1::min(key_vec, *smallest_vec);
+    *biggest_vec = vtype1::max(key_vec, *biggest_vec);
     return amount_gt_pivot;
 }
+
+/*
+ * Partitions keys[left] on its own: it stays where it is if it goes left of
+ * the pivot, otherwise it is swapped to the end and the array gets shorter
+ */
+template <typename vtype1,
+          typename comparator,
+          nan_mode_t nan_mode,
+          typename type_t1,
+          typename type_t2>
+X86_SIMD_SORT_FINLINE void kvpartition_scalar(type_t1 *keys,
+                                              type_t2 *indexes,
+                                              arrsize_t &left,
+                                              arrsize_t &right,
+                                              type_t1 pivot,
+                                              type_t1 *smallest,
+                                              type_t1 *biggest,
+                                              arrsize_t *nan_count)
+{
+    if constexpr (nan_mode == nan_mode_t::route) {
+        if (xss::fp::isnan(keys[left])) {
+            *nan_count += 1;
+            if constexpr (comparator::is_descending) { ++left; }
+            else {
+                right--;
+                std::swap(keys[left], keys[right]);
+                std::swap(indexes[left], indexes[right]);
+            }
+            return;
+        }
+    }
+    UNUSED(nan_count);
+    *smallest = std::min(*smallest, keys[left]);
+    *biggest = std::max(*biggest, keys[left]);
+    if (!comparator::STDSortComparator(keys[left], pivot)) {
+        right--;
+        std::swap(keys[left], keys[right]);
+        std::swap(indexes[left], indexes[right]);
+    }
+    else {
+        ++left;
+    }
+}
 /*
  * Parition an array based on the pivot and returns the index of the
  * last element that is less than equal to the pivot.
  */
 template <typename vtype1,
           typename vtype2,
+          typename comparator,
+          nan_mode_t nan_mode = nan_mode_t::none,
           typename type_t1 = typename vtype1::type_t,
           typename type_t2 = typename vtype2::type_t,
           typename reg_t1 = typename vtype1::reg_t,
@@ -118,20 +222,19 @@ X86_SIMD_SORT_INLINE arrsize_t kvpartition(type_t1 *keys,
                                            arrsize_t right,
                                            type_t1 pivot,
                                            type_t1 *smallest,
-                                           type_t1 *biggest)
+                                           type_t1 *biggest,
+                                           arrsize_t *nan_count = nullptr)
 {
     /* make array length divisible by vtype1::numlanes , shortening the array */
     for (int32_t i = (right - left) % vtype1::numlanes; i > 0; --i) {
-        *smallest = std::min(*smallest, keys[left]);
-        *biggest = std::max(*biggest, keys[left]);
-        if (keys[left] >= pivot) {
-            right--;
-            std::swap(keys[left], keys[right]);
-            std::swap(indexes[left], indexes[right]);
-        }
-        else {
-            ++left;
-        }
+        kvpartition_scalar<vtype1, comparator, nan_mode>(keys,
+                                                         indexes,
+                                                         left,
+                                                         right,
+                                                         pivot,
+                                                         smallest,
+                                                         biggest,
+                                                         nan_count);
     }
 
     if (left == right)
@@ -146,15 +249,17 @@ X86_SIMD_SORT_INLINE arrsize_t kvpartition(type_t1 *keys,
         int32_t amount_gt_pivot;
 
         reg_t2 indexes_vec = vtype2::loadu(indexes + left);
-        amount_gt_pivot = partition_vec<vtype1, vtype2>(keys,
-                                                        indexes,
-                                                        left,
-                                                        left + vtype1::numlanes,
-                                                        keys_vec,
-                                                        indexes_vec,
-                                                        pivot_vec,
-                                                        &min_vec,
-                                                        &max_vec);
+        amount_gt_pivot = partition_vec<vtype1, vtype2, comparator, nan_mode>(
+                keys,
+                indexes,
+                left,
+                left + vtype1::numlanes,
+                keys_vec,
+                indexes_vec,
+                pivot_vec,
+                &min_vec,
+                &max_vec,
+                nan_count);
 
         *smallest = vtype1::reducemin(min_vec);
         *biggest = vtype1::reducemax(max_vec);
@@ -196,41 +301,46 @@ X86_SIMD_SORT_INLINE arrsize_t kvpartition(type_t1 *keys,
         // partition the current vector and save it on both sides of the array
         int32_t amount_gt_pivot;
 
-        amount_gt_pivot
-                = partition_vec<vtype1, vtype2>(keys,
-                                                indexes,
-                                                l_store,
-                                                r_store + vtype1::numlanes,
-                                                keys_vec,
-                                                indexes_vec,
-                                                pivot_vec,
-                                                &min_vec,
-                                                &max_vec);
+        amount_gt_pivot = partition_vec<vtype1, vtype2, comparator, nan_mode>(
+                keys,
+                indexes,
+                l_store,
+                r_store + vtype1::numlanes,
+                keys_vec,
+                indexes_vec,
+                pivot_vec,
+                &min_vec,
+                &max_vec,
+                nan_count);
         r_store -= amount_gt_pivot;
         l_store += (vtype1::numlanes - amount_gt_pivot);
     }
 
     /* partition and save vec_left and vec_right */
     int32_t amount_gt_pivot;
-    amount_gt_pivot = partition_vec<vtype1, vtype2>(keys,
-                                                    indexes,
-                                                    l_store,
-                                                    r_store + vtype1::numlanes,
-                                                    keys_vec_left,
-                                                    indexes_vec_left,
-                                                    pivot_vec,
-                                                    &min_vec,
-                                                    &max_vec);
+    amount_gt_pivot = partition_vec<vtype1, vtype2, comparator, nan_mode>(
+            keys,
+            indexes,
+            l_store,
+            r_store + vtype1::numlanes,
+            keys_vec_left,
+            indexes_vec_left,
+            pivot_vec,
+            &min_vec,
+            &max_vec,
+            nan_count);
     l_store += (vtype1::numlanes - amount_gt_pivot);
-    amount_gt_pivot = partition_vec<vtype1, vtype2>(keys,
-                                                    indexes,
-                                                    l_store,
-                                                    l_store + vtype1::numlanes,
-                                                    keys_vec_right,
-                                                    indexes_vec_right,
-                                                    pivot_vec,
-                                                    &min_vec,
-                                                    &max_vec);
+    amount_gt_pivot = partition_vec<vtype1, vtype2, comparator, nan_mode>(
+            keys,
+            indexes,
+            l_store,
+            l_store + vtype1::numlanes,
+            keys_vec_right,
+            indexes_vec_right,
+            pivot_vec,
+            &min_vec,
+            &max_vec,
+            nan_count);
     l_store += (vtype1::numlanes - amount_gt_pivot);
     *smallest = vtype1::reducemin(min_vec);
     *biggest = vtype1::reducemax(max_vec);
@@ -239,37 +349,45 @@ X86_SIMD_SORT_INLINE arrsize_t kvpartition(type_t1 *keys,
 
 template <typename vtype1,
           typename vtype2,
+          typename comparator,
           int num_unroll,
+          nan_mode_t nan_mode = nan_mode_t::none,
           typename type_t1 = typename vtype1::type_t,
           typename type_t2 = typename vtype2::type_t,
           typename reg_t1 = typename vtype1::reg_t,
           typename reg_t2 = typename vtype2::reg_t>
-X86_SIMD_SORT_INLINE arrsize_t kvpartition_unrolled(type_t1 *keys,
-                                                    type_t2 *indexes,
-                                                    arrsize_t left,
-                                                    arrsize_t right,
-                                                    type_t1 pivot,
-                                                    type_t1 *smallest,
-                                                    type_t1 *biggest)
+X86_SIMD_SORT_INLINE arrsize_t
+kvpartition_unrolled(type_t1 *keys,
+                     type_t2 *indexes,
+                     arrsize_t left,
+                     arrsize_t right,
+                     type_t1 pivot,
+                     type_t1 *smallest,
+                     type_t1 *biggest,
+                     arrsize_t *nan_count = nullptr)
 {
     if (right - left <= 8 * num_unroll * vtype1::numlanes) {
-        return kvpartition<vtype1, vtype2>(
-                keys, indexes, left, right, pivot, smallest, biggest);
+        return kvpartition<vtype1, vtype2, comparator, nan_mode>(keys,
+                                                                 indexes,
+                                                                 left,
+                                                                 right,
+                                                                 pivot,
+                                                                 smallest,
+                                                                 biggest,
+                                                                 nan_count);
     }
 
     /* make array length divisible by vtype1::numlanes , shortening the array */
     for (int32_t i = ((right - left) % (num_unroll * vtype1::numlanes)); i > 0;
          --i) {
-        *smallest = std::min(*smallest, keys[left]);
-        *biggest = std::max(*biggest, keys[left]);
-        if (keys[left] >= pivot) {
-            right--;
-            std::swap(keys[left], keys[right]);
-            std::swap(indexes[left], indexes[right]);
-        }
-        else {
-            ++left;
-        }
+        kvpartition_scalar<vtype1, comparator, nan_mode>(keys,
+                                                         indexes,
+                                                         left,
+                                                         right,
+                                                         pivot,
+                                                         smallest,
+                                                         biggest,
+                                                         nan_count);
     }
 
     if (left == right) return left;
@@ -328,15 +446,17 @@ X86_SIMD_SORT_INLINE arrsize_t kvpartition_unrolled(type_t1 *keys,
         X86_SIMD_SORT_UNROLL_LOOP(8)
         for (int ii = 0; ii < num_unroll; ++ii) {
             int32_t amount_gt_pivot
-                    = partition_vec<vtype1, vtype2>(keys,
-                                                    indexes,
-                                                    l_store,
-                                                    r_store + vtype1::numlanes,
-                                                    curr_vec[ii],
-                                                    indx_vec[ii],
-                                                    pivot_vec,
-                                                    &min_vec,
-                                                    &max_vec);
+                    = partition_vec<vtype1, vtype2, comparator, nan_mode>(
+                            keys,
+                            indexes,
+                            l_store,
+                            r_store + vtype1::numlanes,
+                            curr_vec[ii],
+                            indx_vec[ii],
+                            pivot_vec,
+                            &min_vec,
+                            &max_vec,
+                            nan_count);
             l_store += (vtype1::numlanes - amount_gt_pivot);
             r_store -= amount_gt_pivot;
         }
@@ -346,30 +466,34 @@ X86_SIMD_SORT_INLINE arrsize_t kvpartition_unrolled(type_t1 *keys,
     X86_SIMD_SORT_UNROLL_LOOP(8)
     for (int ii = 0; ii < num_unroll; ++ii) {
         int32_t amount_gt_pivot
-                = partition_vec<vtype1, vtype2>(keys,
-                                                indexes,
-                                                l_store,
-                                                r_store + vtype1::numlanes,
-                                                key_left[ii],
-                                                indx_left[ii],
-                                                pivot_vec,
-                                                &min_vec,
-                                                &max_vec);
+                = partition_vec<vtype1, vtype2, comparator, nan_mode>(
+                        keys,
+                        indexes,
+                        l_store,
+                        r_store + vtype1::numlanes,
+                        key_left[ii],
+                        indx_left[ii],
+                        pivot_vec,
+                        &min_vec,
+                        &max_vec,
+                        nan_count);
         l_store += (vtype1::numlanes - amount_gt_pivot);
         r_store -= amount_gt_pivot;
     }
     X86_SIMD_SORT_UNROLL_LOOP(8)
     for (int ii = 0; ii < num_unroll; ++ii) {
         int32_t amount_gt_pivot
-                = partition_vec<vtype1, vtype2>(keys,
-                                                indexes,
-                                                l_store,
-                                                r_store + vtype1::numlanes,
-                                                key_right[ii],
-                                                indx_right[ii],
-                                                pivot_vec,
-                                                &min_vec,
-                                                &max_vec);
+                = partition_vec<vtype1, vtype2, comparator, nan_mode>(
+                        keys,
+                        indexes,
+                        l_store,
+                        r_store + vtype1::numlanes,
+                        key_right[ii],
+                        indx_right[ii],
+                        pivot_vec,
+                        &min_vec,
+                        &max_vec,
+                        nan_count);
         l_store += (vtype1::numlanes - amount_gt_pivot);
         r_store -= amount_gt_pivot;
     }
@@ -380,6 +504,7 @@ X86_SIMD_SORT_INLINE arrsize_t kvpartition_unrolled(type_t1 *keys,
 
 template <typename vtype1,
           typename vtype2,
+          typename comparator,
           typename type1_t = typename vtype1::type_t,
           typename type2_t = typename vtype2::type_t>
 X86_SIMD_SORT_INLINE void
@@ -390,8 +515,10 @@ heapify(type1_t *keys, type2_t *indexes, arrsize_t idx, arrsize_t size)
         arrsize_t j = 2 * i + 1;
         if (j >= size) { break; }
         arrsize_t k = j + 1;
-        if (k < size && keys[j] < keys[k]) { j = k; }
-        if (keys[j] < keys[i]) { break; }
+        if (k < size && comparator::STDSortComparator(keys[j], keys[k])) {
+            j = k;
+        }
+        if (comparator::STDSortComparator(keys[j], keys[i])) { break; }
         std::swap(keys[i], keys[j]);
         std::swap(indexes[i], indexes[j]);
         i = j;
@@ -399,6 +526,7 @@ heapify(type1_t *keys, type2_t *indexes, arrsize_t idx, arrsize_t size)
 }
 template <typename vtype1,
           typename vtype2,
+          typename comparator,
           typename type1_t = typename vtype1::type_t,
           typename type2_t = typename vtype2::type_t>
 X86_SIMD_SORT_INLINE void
@@ -406,18 +534,19 @@ heap_sort(type1_t *keys, type2_t *indexes, arrsize_t size)
 {
     if (size <= 1) return;
     for (arrsize_t i = size / 2 - 1;; i--) {
-        heapify<vtype1, vtype2>(keys, indexes, i, size);
+        heapify<vtype1, vtype2, comparator>(keys, indexes, i, size);
         if (i == 0) { break; }
     }
     for (arrsize_t i = size - 1; i > 0; i--) {
         std::swap(keys[0], keys[i]);
         std::swap(indexes[0], indexes[i]);
-        heapify<vtype1, vtype2>(keys, indexes, 0, i);
+        heapify<vtype1, vtype2, comparator>(keys, indexes, 0, i);
     }
 }
 
 template <typename vtype1,
           typename vtype2,
+          typename comparator,
           typename type1_t = typename vtype1::type_t,
           typename type2_t = typename vtype2::type_t>
 X86_SIMD_SORT_INLINE void kvsort_(type1_t *keys,
@@ -431,7 +560,7 @@ X86_SIMD_SORT_INLINE void kvsort_(type1_t *keys,
      * Resort to std::sort if quicksort isnt making any progress
      */
     if (max_iters <= 0) {
-        heap_sort<vtype1, vtype2>(
+        heap_sort<vtype1, vtype2, comparator>(
                 keys + left, indexes + left, right - left + 1);
         return;
     }
@@ -439,13 +568,11 @@ X86_SIMD_SORT_INLINE void kvsort_(type1_t *keys,
      * Base case: use bitonic networks to sort arrays <= 128
      */
     if (right + 1 - left <= 128) {
-        kvsort_n<vtype1, vtype2, 128>(
+        kvsort_n<vtype1, vtype2, comparator, 128>(
                 keys + left, indexes + left, (int32_t)(right + 1 - left));
         return;
     }
 
-    // Ascending comparator for this vtype
-    using comparator = Comparator<vtype1, false>;
     type1_t pivot;
     auto pivot_result
             = get_pivot_smart<vtype1, comparator, type1_t>(keys, left, right);
@@ -455,62 +582,65 @@ X86_SIMD_SORT_INLINE void kvsort_(type1_t *keys,
 
     type1_t smallest = vtype1::type_max();
     type1_t biggest = vtype1::type_min();
-    arrsize_t pivot_index = kvpartition_unrolled<vtype1, vtype2, 4>(
+    arrsize_t pivot_index = kvpartition_unrolled<vtype1, vtype2, comparator, 4>(
             keys, indexes, left, right + 1, pivot, &smallest, &biggest);
 
     if (pivot_result.result == pivot_result_t::Only2Values) { return; }
 
+    type1_t leftmostValue = comparator::leftmost(smallest, biggest);
+    type1_t rightmostValue = comparator::rightmost(smallest, biggest);
+
 #ifdef XSS_COMPILE_OPENMP
-    if (pivot != smallest) {
+    if (pivot != leftmostValue) {
         bool parallel_left = (pivot_index - left) > task_threshold;
         if (parallel_left) {
 #pragma omp task
-            kvsort_<vtype1, vtype2>(keys,
-                                    indexes,
-                                    left,
-                                    pivot_index - 1,
-                                    max_iters - 1,
-                                    task_threshold);
+            kvsort_<vtype1, vtype2, comparator>(keys,
+                                                indexes,
+                                                left,
+                                                pivot_index - 1,
+                                                max_iters - 1,
+                                                task_threshold);
         }
         else {
-            kvsort_<vtype1, vtype2>(keys,
-                                    indexes,
-                                    left,
-                                    pivot_index - 1,
-                                    max_iters - 1,
-                                    task_threshold);
+            kvsort_<vtype1, vtype2, comparator>(keys,
+                                                indexes,
+                                                left,
+                                                pivot_index - 1,
+                                                max_iters - 1,
+                                                task_threshold);
         }
     }
-    if (pivot != biggest) {
+    if (pivot != rightmostValue) {
         bool parallel_right = (right - pivot_index) > task_threshold;
 
         if (parallel_right) {
 #pragma omp task
-            kvsort_<vtype1, vtype2>(keys,
-                                    indexes,
-                                    pivot_index,
-                                    right,
-                                    max_iters - 1,
-                                    task_threshold);
+            kvsort_<vtype1, vtype2, comparator>(keys,
+                                                indexes,
+                                                pivot_index,
+                                                right,
+                                                max_iters - 1,
+                                                task_threshold);
         }
         else {
-            kvsort_<vtype1, vtype2>(keys,
-                                    indexes,
-                                    pivot_index,
-                                    right,
-                                    max_iters - 1,
-                                    task_threshold);
+            kvsort_<vtype1, vtype2, comparator>(keys,
+                                                indexes,
+                                                pivot_index,
+                                                right,
+                                                max_iters - 1,
+                                                task_threshold);
         }
     }
 #else
     UNUSED(task_threshold);
 
-    if (pivot != smallest) {
-        kvsort_<vtype1, vtype2>(
+    if (pivot != leftmostValue) {
+        kvsort_<vtype1, vtype2, comparator>(
                 keys, indexes, left, pivot_index - 1, max_iters - 1, 0);
     }
-    if (pivot != biggest) {
-        kvsort_<vtype1, vtype2>(
+    if (pivot != rightmostValue) {
+        kvsort_<vtype1, vtype2, comparator>(
                 keys, indexes, pivot_index, right, max_iters - 1, 0);
     }
 #endif
@@ -518,6 +648,7 @@ X86_SIMD_SORT_INLINE void kvsort_(type1_t *keys,
 
 template <typename vtype1,
           typename vtype2,
+          typename comparator,
           typename type1_t = typename vtype1::type_t,
           typename type2_t = typename vtype2::type_t>
 X86_SIMD_SORT_INLINE void kvselect_(type1_t *keys,
@@ -531,7 +662,7 @@ X86_SIMD_SORT_INLINE void kvselect_(type1_t *keys,
      * Resort to std::sort if quicksort isnt making any progress
      */
     if (max_iters <= 0) {
-        heap_sort<vtype1, vtype2>(
+        heap_sort<vtype1, vtype2, comparator>(
                 keys + left, indexes + left, right - left + 1);
         return;
     }
@@ -540,7 +671,7 @@ X86_SIMD_SORT_INLINE void kvselect_(type1_t *keys,
      */
     if (right + 1 - left <= 128) {
 
-        kvsort_n<vtype1, vtype2, 128>(
+        kvsort_n<vtype1, vtype2, comparator, 128>(
                 keys + left, indexes + left, (int32_t)(right + 1 - left));
         return;
     }
@@ -548,19 +679,175 @@ X86_SIMD_SORT_INLINE void kvselect_(type1_t *keys,
     type1_t pivot = get_pivot_blocks<vtype1>(keys, left, right);
     type1_t smallest = vtype1::type_max();
     type1_t biggest = vtype1::type_min();
-    arrsize_t pivot_index = kvpartition_unrolled<vtype1, vtype2, 4>(
+    arrsize_t pivot_index = kvpartition_unrolled<vtype1, vtype2, comparator, 4>(
             keys, indexes, left, right + 1, pivot, &smallest, &biggest);
 
-    if ((pivot != smallest) && (pos < pivot_index)) {
-        kvselect_<vtype1, vtype2>(
+    type1_t leftmostValue = comparator::leftmost(smallest, biggest);
+    type1_t rightmostValue = comparator::rightmost(smallest, biggest);
+
+    if ((pivot != leftmostValue) && (pos < pivot_index)) {
+        kvselect_<vtype1, vtype2, comparator>(
                 keys, indexes, pos, left, pivot_index - 1, max_iters - 1);
     }
-    else if ((pivot != biggest) && (pos >= pivot_index)) {
-        kvselect_<vtype1, vtype2>(
+    else if ((pivot != rightmostValue) && (pos >= pivot_index)) {
+        kvselect_<vtype1, vtype2, comparator>(
                 keys, indexes, pos, pivot_index, right, max_iters - 1);
     }
 }
 
+template <typename keytype,
+          typename valtype,
+          typename comparator,
+          typename T1,
+          typename T2>
+X86_SIMD_SORT_INLINE void kvsort_toplevel_(
+        T1 *keys, T2 *indexes, arrsize_t left, arrsize_t right, int maxiters)
+{
+#ifdef XSS_COMPILE_OPENMP
+
+    arrsize_t arrsize = right + 1 - left;
+    bool use_parallel = arrsize > 10000;
+
+    if (use_parallel) {
+        int thread_count = xss_get_num_threads();
+        arrsize_t task_threshold = std::max((arrsize_t)10000, arrsize / 100);
+
+        // We use omp parallel and then omp single to setup the threads that will run the omp task calls in kvsort_
+        // The omp single prevents multiple threads from running the initial kvsort_ simultaneously and causing problems
+        // Note that we do not use the if(...) clause built into OpenMP, because it causes a performance regression for small arrays
+#pragma omp parallel num_threads(thread_count)
+#pragma omp single
+        kvsort_<keytype, valtype, comparator>(
+                keys, indexes, left, right, maxiters, task_threshold);
+#pragma omp taskwait
+    }
+    else {
+        kvsort_<keytype, valtype, comparator>(
+                keys,
+                indexes,
+                left,
+                right,
+                maxiters,
+                std::numeric_limits<arrsize_t>::max());
+    }
+#else
+    kvsort_<keytype, valtype, comparator>(
+            keys, indexes, left, right, maxiters, 0);
+#endif
+}
+
+/*
+ * First partition of keys that may hold NaNs, which moves them to the side of
+ * the pivot they sort to and counts them. Returns the pivot index, or
+ * arrsize if the arrays are too small to be worth partitioning and have been
+ * left untouched.
+ */
+template <typename keytype,
+          typename valtype,
+          typename comparator,
+          typename T1,
+          typename T2>
+X86_SIMD_SORT_INLINE arrsize_t kvpartition_nans_(T1 *keys,
+                                                 T2 *indexes,
+                                                 arrsize_t arrsize,
+                                                 arrsize_t *nan_count)
+{
+    if (arrsize <= 128) return arrsize;
+
+    T1 pivot = get_pivot_with_nans<keytype>(keys, 0, arrsize - 1);
+    T1 smallest = keytype::type_max();
+    T1 biggest = keytype::type_min();
+    return kvpartition_unrolled<keytype,
+                                valtype,
+                                comparator,
+                                4,
+                                nan_mode_t::route>(
+            keys, indexes, 0, arrsize, pivot, &smallest, &biggest, nan_count);
+}
+
+/*
+ * NaN keys are moved to the end of the array for an ascending sort and to the
+ * start of the array for a descending sort, the rest is sorted with the
+ * comparator. Unless the radix sort takes the array, the NaNs are found in
+ * the first partition, and only the side of the pivot they sort to has to be
+ * searched for them afterwards.
+ */
+template <typename keytype,
+          typename valtype,
+          bool descending,
+          typename T1,
+          typename T2>
+X86_SIMD_SORT_INLINE void xss_qsort_kv_(
+        T1 *keys, T2 *indexes, arrsize_t arrsize, bool hasnan, int maxiters)
+{
+    using comparator =
+            typename std::conditional<descending,
+                                      Comparator<keytype, true>,
+                                      Comparator<keytype, false>>::type;
+
+    arrsize_t index_first_elem = 0;
+    arrsize_t index_last_elem = arrsize - 1;
+    if constexpr (xss::fp::is_floating_point_v<T1>) {
+        if (UNLIKELY(hasnan) && maxiters > 0 && !xss_use_radix<T1>(arrsize)) {
+            arrsize_t nan_count = 0;
+            arrsize_t pivot_index
+                    = kvpartition_nans_<keytype, valtype, comparator>(
+                            keys, indexes, arrsize, &nan_count);
+            if (pivot_index < arrsize) {
+                arrsize_t left = 0;
+                arrsize_t end = arrsize;
+                if (nan_count > 0) {
+                    if constexpr (descending) {
+                        left = move_nans_to_start_of_array<T1, T2, keytype>(
+                                keys, indexes, pivot_index);
+                    }
+                    else {
+                        end = pivot_index + 1
+                                + move_nans_to_end_of_array<T1, T2, keytype>(
+                                        keys + pivot_index,
+                                        indexes + pivot_index,
+                                        arrsize - pivot_index);
+                    }
+                }
+                if (pivot_index - left > 1) {
+                    kvsort_toplevel_<keytype, valtype, comparator>(
+                            keys, indexes, left, pivot_index - 1, maxiters - 1);
+                }
+                if (end - pivot_index > 1) {
+                    kvsort_toplevel_<keytype, valtype, comparator>(
+                            keys, indexes, pivot_index, end - 1, maxiters - 1);
+                }
+                return;
+            }
+        }
+        if (UNLIKELY(hasnan)) {
+            if constexpr (descending) {
+                index_first_elem
+                        = move_nans_to_start_of_array<T1, T2, keytype>(
+                                keys, indexes, arrsize);
+            }
+            else {
+                index_last_elem
+                        = move_nans_to_end_of_array<T1, T2, keytype>(
+                                keys, indexes, arrsize);
+            }
+        }
+    }
+    else {
+        UNUSED(hasnan);
+    }
+    if (index_first_elem > index_last_elem) return;
+
+    if (xss_radix_kvsort<descending>(keys + index_first_elem,
+                                     indexes + index_first_elem,
+                                     index_last_elem - index_first_elem + 1)) {
+        return;
+    }
+
+    kvsort_toplevel_<keytype, valtype, comparator>(
+            keys, indexes, index_first_elem, index_last_elem, maxiters);
+}
+
 template <typename T1,
           typename T2,
           template <typename...>
@@ -593,63 +880,88 @@ X86_SIMD_SORT_INLINE void xss_qsort_kv(
 #endif // XSS_TEST_KEYVALUE_BASE_CASE
 
     if (minarrsize) {
-        arrsize_t index_last_elem = arrsize - 1;
-        if constexpr (xss::fp::is_floating_point_v<T1>) {
-            if (UNLIKELY(hasnan)) {
-                index_last_elem
-                        = move_nans_to_end_of_array<T1, T2, full_vector<T1>>(
-                                keys, indexes, arrsize);
-            }
+        if (descending) {
+            xss_qsort_kv_<keytype, valtype, true>(
+                    keys, indexes, arrsize, hasnan, maxiters);
         }
         else {
-            UNUSED(hasnan);
+            xss_qsort_kv_<keytype, valtype, false>(
+                    keys, indexes, arrsize, hasnan, maxiters);
         }
+    }
 
-#ifdef XSS_COMPILE_OPENMP
-
-        bool use_parallel = arrsize > 10000;
-
-        if (use_parallel) {
-            int thread_count = xss_get_num_threads();
-            arrsize_t task_threshold
-                    = std::max((arrsize_t)10000, arrsize / 100);
+#ifdef __MMX__
+    // Workaround for compiler bug generating MMX instructions without emms
+    _mm_empty();
+#endif
+}
 
-            // We use omp parallel and then omp single to setup the threads that will run the omp task calls in kvsort_
-            // The omp single prevents multiple threads from running the initial kvsort_ simultaneously and causing problems
-            // Note that we do not use the if(...) clause built into OpenMP, because it causes a performance regression for small arrays
-#pragma omp parallel num_threads(thread_count)
-#pragma omp single
-            kvsort_<keytype, valtype>(keys,
-                                      indexes,
-                                      0,
-                                      index_last_elem,
-                                      maxiters,
-                                      task_threshold);
-#pragma omp taskwait
+template <typename keytype,
+          typename valtype,
+          bool descending,
+          typename T1,
+          typename T2>
+X86_SIMD_SORT_INLINE void xss_select_kv_(T1 *keys,
+                                         T2 *indexes,
+                                         arrsize_t k,
+                                         arrsize_t arrsize,
+                                         bool hasnan,
+                                         int maxiters)
+{
+    using comparator =
+            typename std::conditional<descending,
+                                      Comparator<keytype, true>,
+                                      Comparator<keytype, false>>::type;
+
+    arrsize_t index_first_elem = 0;
+    arrsize_t index_end = arrsize;
+    if constexpr (xss::fp::is_floating_point_v<T1>) {
+        arrsize_t nan_count = 0;
+        arrsize_t pivot_index = arrsize;
+        if (UNLIKELY(hasnan) && maxiters > 0) {
+            pivot_index = kvpartition_nans_<keytype, valtype, comparator>(
+                    keys, indexes, arrsize, &nan_count);
         }
-        else {
-            kvsort_<keytype, valtype>(keys,
-                                      indexes,
-                                      0,
-                                      index_last_elem,
-                                      maxiters,
-                                      std::numeric_limits<arrsize_t>::max());
+        if (pivot_index < arrsize) {
+            // only the side of the pivot that holds k is searched for NaNs
+            if (k < pivot_index) {
+                index_end = pivot_index;
+                if (descending && nan_count > 0) {
+                    index_first_elem
+                            = move_nans_to_start_of_array<T1, T2, keytype>(
+                                    keys, indexes, pivot_index);
+                }
+            }
+            else {
+                index_first_elem = pivot_index;
+                if (!descending && nan_count > 0) {
+                    index_end = pivot_index + 1
+                            + move_nans_to_end_of_array<T1, T2, keytype>(
+                                    keys + pivot_index,
+                                    indexes + pivot_index,
+                                    arrsize - pivot_index);
+                }
+            }
         }
-#else
-        kvsort_<keytype, valtype>(
-                keys, indexes, 0, index_last_elem, maxiters, 0);
-#endif
-
-        if (descending) {
-            std::reverse(keys, keys + arrsize);
-            std::reverse(indexes, indexes + arrsize);
+        else if (UNLIKELY(hasnan)) {
+            if constexpr (descending) {
+                index_first_elem
+                        = move_nans_to_start_of_array<T1, T2, keytype>(
+                                keys, indexes, arrsize);
+            }
+            else {
+                index_end = move_nans_to_end_of_array<T1, T2, keytype>(
+                                    keys, indexes, arrsize)
+                        + 1;
+            }
         }
     }
 
-#ifdef __MMX__
-    // Workaround for compiler bug generating MMX instructions without emms
-    _mm_empty();
-#endif
+    UNUSED(hasnan);
+    if (index_first_elem <= k && k < index_end) {
+        kvselect_<keytype, valtype, comparator>(
+                keys, indexes, k, index_first_elem, index_end - 1, maxiters);
+    }
 }
 
 template <typename T1,
@@ -688,26 +1000,13 @@ X86_SIMD_SORT_INLINE void xss_select_kv(T1 *keys,
 #endif // XSS_TEST_KEYVALUE_BASE_CASE
 
     if (minarrsize) {
-        if (descending) { k = arrsize - 1 - k; }
-
-        arrsize_t index_last_elem = arrsize - 1;
-        if constexpr (xss::fp::is_floating_point_v<T1>) {
-            if (UNLIKELY(hasnan)) {
-                index_last_elem
-                        = move_nans_to_end_of_array<T1, T2, full_vector<T1>>(
-                                keys, indexes, arrsize);
-            }
-        }
-
-        UNUSED(hasnan);
-        if (index_last_elem >= k) {
-            kvselect_<keytype, valtype>(
-                    keys, indexes, k, 0, index_last_elem, maxiters);
-        }
-
         if (descending) {
-            std::reverse(keys, keys + arrsize);
-            std::reverse(indexes, indexes + arrsize);
+            xss_select_kv_<keytype, valtype, true>(
+                    keys, indexes, k, arrsize, hasnan, maxiters);
+        }
+        else {
+            xss_select_kv_<keytype, valtype, false>(
+                    keys, indexes, k, arrsize, hasnan, maxiters);
         }
     }
 
@@ -731,12 +1030,56 @@ X86_SIMD_SORT_INLINE void xss_partial_sort_kv(T1 *keys,
                                               bool descending)
 {
     if (k == 0) return;
+    // NaNs fail every compare against the threshold, so skip the filter
+    if (!hasnan && xss_use_topk(k, arrsize)) {
+        using vtype = full_vector<T1>;
+        auto swap = [keys, indexes](arrsize_t ii, arrsize_t jj) {
+            std::swap(keys[ii], keys[jj]);
+            std::swap(indexes[ii], indexes[jj]);
+        };
+        auto select = [keys, indexes, k, descending](arrsize_t size) {
+            xss_select_kv<T1, T2, full_vector, half_vector>(
+                    keys, indexes, k - 1, size, false, descending);
+        };
+        if (descending) {
+            arrsize = topk_filter_<vtype, Comparator<vtype, true>>(
+                    keys, k, arrsize, swap, select);
+        }
+        else {
+            arrsize = topk_filter_<vtype, Comparator<vtype, false>>(
+                    keys, k, arrsize, swap, select);
+        }
+    }
     xss_select_kv<T1, T2, full_vector, half_vector>(
             keys, indexes, k - 1, arrsize, hasnan, descending);
     xss_qsort_kv<T1, T2, full_vector, half_vector>(
             keys, indexes, k - 1, hasnan, descending);
 }
 
+/*
+ * There are no 16-bit key-value kernels: 16-bit keys and values are widened to
+ * 32 bits, which maps every combination of types onto one of the 32/64-bit
+ * kernels, and narrowed back into the caller's arrays once sorted.
+ */
+template <typename T1, typename T2, typename Func>
+X86_SIMD_SORT_INLINE void
+xss_kv_with_32bit_types(T1 *keys, T2 *indexes, arrsize_t arrsize, Func func)
+{
+    if constexpr (sizeof(T1) == sizeof(int16_t)) {
+        auto wkeys = xss_widen_16bit(keys, arrsize);
+        xss_kv_with_32bit_types(wkeys.get(), indexes, arrsize, func);
+        xss_narrow_16bit(wkeys.get(), keys, arrsize);
+    }
+    else if constexpr (sizeof(T2) == sizeof(int16_t)) {
+        auto wvals = xss_widen_16bit(indexes, arrsize);
+        xss_kv_with_32bit_types(keys, wvals.get(), arrsize, func);
+        xss_narrow_16bit(wvals.get(), indexes, arrsize);
+    }
+    else {
+        func(keys, indexes);
+    }
+}
+
 template <typename T1, typename T2>
 X86_SIMD_SORT_INLINE void avx512_qsort_kv(T1 *keys,
                                           T2 *indexes,
@@ -744,8 +1087,13 @@ X86_SIMD_SORT_INLINE void avx512_qsort_kv(T1 *keys,
                                           bool hasnan = false,
                                           bool descending = false)
 {
-    xss_qsort_kv<T1, T2, zmm_vector, ymm_vector>(
-            keys, indexes, arrsize, hasnan, descending);
+    auto func = [&](auto *wkeys, auto *wvals) {
+        using W1 = std::remove_pointer_t<decltype(wkeys)>;
+        using W2 = std::remove_pointer_t<decltype(wvals)>;
+        xss_qsort_kv<W1, W2, zmm_vector, ymm_vector>(
+                wkeys, wvals, arrsize, hasnan, descending);
+    };
+    xss_kv_with_32bit_types(keys, indexes, arrsize, func);
 }
 
 template <typename T1, typename T2>
@@ -755,8 +1103,13 @@ X86_SIMD_SORT_INLINE void avx2_qsort_kv(T1 *keys,
                                         bool hasnan = false,
                                         bool descending = false)
 {
-    xss_qsort_kv<T1, T2, avx2_vector, avx2_half_vector>(
-            keys, indexes, arrsize, hasnan, descending);
+    auto func = [&](auto *wkeys, auto *wvals) {
+        using W1 = std::remove_pointer_t<decltype(wkeys)>;
+        using W2 = std::remove_pointer_t<decltype(wvals)>;
+        xss_qsort_kv<W1, W2, avx2_vector, avx2_half_vector>(
+                wkeys, wvals, arrsize, hasnan, descending);
+    };
+    xss_kv_with_32bit_types(keys, indexes, arrsize, func);
 }
 
 template <typename T1, typename T2>
@@ -767,8 +1120,13 @@ X86_SIMD_SORT_INLINE void avx512_select_kv(T1 *keys,
                                            bool hasnan = false,
                                            bool descending = false)
 {
-    xss_select_kv<T1, T2, zmm_vector, ymm_vector>(
-            keys, indexes, k, arrsize, hasnan, descending);
+    auto func = [&](auto *wkeys, auto *wvals) {
+        using W1 = std::remove_pointer_t<decltype(wkeys)>;
+        using W2 = std::remove_pointer_t<decltype(wvals)>;
+        xss_select_kv<W1, W2, zmm_vector, ymm_vector>(
+                wkeys, wvals, k, arrsize, hasnan, descending);
+    };
+    xss_kv_with_32bit_types(keys, indexes, arrsize, func);
 }
 
 template <typename T1, typename T2>
@@ -779,8 +1137,13 @@ X86_SIMD_SORT_INLINE void avx2_select_kv(T1 *keys,
                                          bool hasnan = false,
                                          bool descending = false)
 {
-    xss_select_kv<T1, T2, avx2_vector, avx2_half_vector>(
-            keys, indexes, k, arrsize, hasnan, descending);
+    auto func = [&](auto *wkeys, auto *wvals) {
+        using W1 = std::remove_pointer_t<decltype(wkeys)>;
+        using W2 = std::remove_pointer_t<decltype(wvals)>;
+        xss_select_kv<W1, W2, avx2_vector, avx2_half_vector>(
+                wkeys, wvals, k, arrsize, hasnan, descending);
+    };
+    xss_kv_with_32bit_types(keys, indexes, arrsize, func);
 }
 
 template <typename T1, typename T2>
@@ -791,8 +1154,13 @@ X86_SIMD_SORT_INLINE void avx512_partial_sort_kv(T1 *keys,
                                                  bool hasnan = false,
                                                  bool descending = false)
 {
-    xss_partial_sort_kv<T1, T2, zmm_vector, ymm_vector>(
-            keys, indexes, k, arrsize, hasnan, descending);
+    auto func = [&](auto *wkeys, auto *wvals) {
+        using W1 = std::remove_pointer_t<decltype(wkeys)>;
+        using W2 = std::remove_pointer_t<decltype(wvals)>;
+        xss_partial_sort_kv<W1, W2, zmm_vector, ymm_vector>(
+                wkeys, wvals, k, arrsize, hasnan, descending);
+    };
+    xss_kv_with_32bit_types(keys, indexes, arrsize, func);
 }
 
 template <typename T1, typename T2>
@@ -803,7 +1171,12 @@ X86_SIMD_SORT_INLINE void avx2_partial_sort_kv(T1 *keys,
                                                bool hasnan = false,
                                                bool descending = false)
 {
-    xss_partial_sort_kv<T1, T2, avx2_vector, avx2_half_vector>(
-            keys, indexes, k, arrsize, hasnan, descending);
+    auto func = [&](auto *wkeys, auto *wvals) {
+        using W1 = std::remove_pointer_t<decltype(wkeys)>;
+        using W2 = std::remove_pointer_t<decltype(wvals)>;
+        xss_partial_sort_kv<W1, W2, avx2_vector, avx2_half_vector>(
+                wkeys, wvals, k, arrsize, hasnan, descending);
+    };
+    xss_kv_with_32bit_types(keys, indexes, arrsize, func);
 }
 #endif // AVX512_QSORT_64BIT_KV
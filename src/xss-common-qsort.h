@@ -38,6 +38,10 @@
 #include "xss-network-qsort.hpp"
 #include "xss-common-comparators.hpp"
 #include "xss-reg-networks.hpp"
+#include "xss-thread-pool.hpp"
+#include "xss-counting-sort.hpp"
+#include "xss-radix-sort.hpp"
+#include "xss-presorted.hpp"
 
 template <typename T>
 bool is_a_nan(T elem)
@@ -179,6 +183,82 @@ X86_SIMD_SORT_INLINE arrsize_t move_nans_to_start_of_array(T *arr,
     return count;
 }
 
+/*
+ * Same as above, but vectors of vtype without NaNs are skipped with one
+ * compare, which makes the scan run at memory speed when NaNs are rare
+ */
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE arrsize_t move_nans_to_end_of_array(T *arr, arrsize_t size)
+{
+    using reg_t = typename vtype::reg_t;
+
+    arrsize_t jj = size - 1;
+    arrsize_t ii = 0;
+    arrsize_t count = 0;
+
+    while (ii + vtype::numlanes < jj) {
+        reg_t in = vtype::loadu(arr + ii);
+        auto nanmask = vtype::convert_mask_to_int(
+                vtype::template fpclass<0x01 | 0x80>(in));
+        if (nanmask == 0x00) {
+            ii += vtype::numlanes;
+            continue;
+        }
+        for (int offset = 0; offset < vtype::numlanes; offset++) {
+            if (is_a_nan(arr[ii])) {
+                std::swap(arr[ii], arr[jj]);
+                jj -= 1;
+                count++;
+            }
+            else {
+                ii += 1;
+            }
+        }
+    }
+    while (ii < jj) {
+        if (is_a_nan(arr[ii])) {
+            std::swap(arr[ii], arr[jj]);
+            jj -= 1;
+            count++;
+        }
+        else {
+            ii += 1;
+        }
+    }
+    if (is_a_nan(arr[ii])) { count++; }
+    return size - count - 1;
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE arrsize_t move_nans_to_start_of_array(T *arr,
+                                                           arrsize_t size)
+{
+    using reg_t = typename vtype::reg_t;
+
+    arrsize_t count = 0;
+    arrsize_t i = 0;
+
+    for (; i + vtype::numlanes <= size; i += vtype::numlanes) {
+        reg_t in = vtype::loadu(arr + i);
+        auto nanmask = vtype::convert_mask_to_int(
+                vtype::template fpclass<0x01 | 0x80>(in));
+        if (nanmask == 0x00) { continue; }
+        for (arrsize_t j = i; j < i + vtype::numlanes; j++) {
+            if (is_a_nan(arr[j])) {
+                std::swap(arr[count], arr[j]);
+                count++;
+            }
+        }
+    }
+    for (; i < size; i++) {
+        if (is_a_nan(arr[i])) {
+            std::swap(arr[count], arr[i]);
+            count++;
+        }
+    }
+    return count;
+}
+
 template <typename vtype, typename T>
 X86_SIMD_SORT_INLINE bool comparison_func(const T &a, const T &b)
 {
@@ -221,9 +301,19 @@ int avx512_double_compressstore(type_t *left_addr,
     return amount_ge_pivot;
 }
 
+/*
+ * What a partition does with NaNs, for the first partition of a floating-point
+ * array that may hold them. Either way they are counted. With replace they
+ * are replaced by vtype::type_max(), and with route they are moved unchanged
+ * to the side of the array they sort to: to the right of the pivot for an
+ * ascending sort and to the left of it for a descending one.
+ */
+enum class nan_mode_t : int { none, replace, route };
+
 // Generic function dispatches to AVX2 or AVX512 code
 template <typename vtype,
           typename comparator,
+          nan_mode_t nan_mode = nan_mode_t::none,
           typename type_t,
           typename reg_t = typename vtype::reg_t>
 X86_SIMD_SORT_INLINE arrsize_t partition_vec(type_t *l_store,
@@ -231,42 +321,103 @@ X86_SIMD_SORT_INLINE arrsize_t partition_vec(type_t *l_store,
                                              const reg_t curr_vec,
                                              const reg_t pivot_vec,
                                              reg_t &smallest_vec,
-                                             reg_t &biggest_vec)
+                                             reg_t &biggest_vec,
+                                             arrsize_t *nan_count = nullptr)
 {
+    // vec is stored, cmp_vec compared to the pivot and key_vec goes into the
+    // smallest and biggest values, which all differ only in their NaN lanes
+    reg_t vec = curr_vec;
+    reg_t cmp_vec = curr_vec;
+    reg_t key_vec = curr_vec;
+    if constexpr (nan_mode != nan_mode_t::none) {
+        auto nanmask = vtype::template fpclass<0x01 | 0x80>(curr_vec);
+        *nan_count += _mm_popcnt_u32(vtype::convert_mask_to_int(nanmask));
+        key_vec = vtype::mask_mov(curr_vec, nanmask, vtype::zmm_max());
+        if constexpr (nan_mode == nan_mode_t::replace) {
+            vec = key_vec;
+            cmp_vec = key_vec;
+        }
+        else if constexpr (!comparator::is_descending) {
+            // NaNs fail every compare, which leaves them left of the pivot
+            cmp_vec = key_vec;
+        }
+    }
+    UNUSED(nan_count);
+
     typename vtype::opmask_t right_mask
-            = comparator::PartitionComparator(curr_vec, pivot_vec);
+            = comparator::PartitionComparator(cmp_vec, pivot_vec);
 
-    int amount_ge_pivot = vtype::double_compressstore(
-            l_store, r_store, right_mask, curr_vec);
+    int amount_ge_pivot
+            = vtype::double_compressstore(l_store, r_store, right_mask, vec);
 
-    smallest_vec = vtype::min(curr_vec, smallest_vec);
-    biggest_vec = vtype::max(curr_vec, biggest_vec);
+    smallest_vec = vtype::min(key_vec, smallest_vec);
+    biggest_vec = vtype::max(key_vec, biggest_vec);
 
     return amount_ge_pivot;
 }
 
+/*
+ * Partitions arr[left] on its own: it stays where it is if it goes left of the
+ * pivot, otherwise it is swapped to the end and the array gets shorter
+ */
+template <typename vtype,
+          typename comparator,
+          nan_mode_t nan_mode,
+          typename type_t>
+X86_SIMD_SORT_FINLINE void partition_scalar(type_t *arr,
+                                            arrsize_t &left,
+                                            arrsize_t &right,
+                                            type_t pivot,
+                                            type_t *smallest,
+                                            type_t *biggest,
+                                            arrsize_t *nan_count)
+{
+    if constexpr (nan_mode != nan_mode_t::none) {
+        if (xss::fp::isnan(arr[left])) {
+            *nan_count += 1;
+            if constexpr (nan_mode == nan_mode_t::replace) {
+                arr[left] = vtype::type_max();
+            }
+            else {
+                if constexpr (comparator::is_descending) { ++left; }
+                else {
+                    std::swap(arr[left], arr[--right]);
+                }
+                return;
+            }
+        }
+    }
+    UNUSED(nan_count);
+    *smallest = std::min(*smallest, arr[left], comparison_func<vtype>);
+    *biggest = std::max(*biggest, arr[left], comparison_func<vtype>);
+    if (!comparator::STDSortComparator(arr[left], pivot)) {
+        std::swap(arr[left], arr[--right]);
+    }
+    else {
+        ++left;
+    }
+}
+
 /*
  * Parition an array based on the pivot and returns the index of the
  * first element that is greater than or equal to the pivot.
  */
-template <typename vtype, typename comparator, typename type_t>
+template <typename vtype,
+          typename comparator,
+          nan_mode_t nan_mode = nan_mode_t::none,
+          typename type_t>
 X86_SIMD_SORT_INLINE arrsize_t partition(type_t *arr,
                                          arrsize_t left,
                                          arrsize_t right,
                                          type_t pivot,
                                          type_t *smallest,
-                                         type_t *biggest)
+                                         type_t *biggest,
+                                         arrsize_t *nan_count = nullptr)
 {
     /* make array length divisible by vtype::numlanes , shortening the array */
     for (int32_t i = (right - left) % vtype::numlanes; i > 0; --i) {
-        *smallest = std::min(*smallest, arr[left], comparison_func<vtype>);
-        *biggest = std::max(*biggest, arr[left], comparison_func<vtype>);
-        if (!comparator::STDSortComparator(arr[left], pivot)) {
-            std::swap(arr[left], arr[--right]);
-        }
-        else {
-            ++left;
-        }
+        partition_scalar<vtype, comparator, nan_mode>(
+                arr, left, right, pivot, smallest, biggest, nan_count);
     }
 
     if (left == right)
@@ -282,13 +433,14 @@ X86_SIMD_SORT_INLINE arrsize_t partition(type_t *arr,
         arrsize_t unpartitioned = right - left - vtype::numlanes;
         arrsize_t l_store = left;
 
-        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator>(
+        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator, nan_mode>(
                 arr + l_store,
                 arr + l_store + unpartitioned,
                 vec,
                 pivot_vec,
                 min_vec,
-                max_vec);
+                max_vec,
+                nan_count);
         l_store += (vtype::numlanes - amount_ge_pivot);
         *smallest = vtype::reducemin(min_vec);
         *biggest = vtype::reducemax(max_vec);
@@ -321,35 +473,38 @@ X86_SIMD_SORT_INLINE arrsize_t partition(type_t *arr,
             left += vtype::numlanes;
         }
         // partition the current vector and save it on both sides of the array
-        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator>(
+        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator, nan_mode>(
                 arr + l_store,
                 arr + l_store + unpartitioned,
                 curr_vec,
                 pivot_vec,
                 min_vec,
-                max_vec);
+                max_vec,
+                nan_count);
         l_store += (vtype::numlanes - amount_ge_pivot);
         unpartitioned -= vtype::numlanes;
     }
 
     /* partition and save vec_left and vec_right */
-    arrsize_t amount_ge_pivot
-            = partition_vec<vtype, comparator>(arr + l_store,
-                                               arr + l_store + unpartitioned,
-                                               vec_left,
-                                               pivot_vec,
-                                               min_vec,
-                                               max_vec);
+    arrsize_t amount_ge_pivot = partition_vec<vtype, comparator, nan_mode>(
+            arr + l_store,
+            arr + l_store + unpartitioned,
+            vec_left,
+            pivot_vec,
+            min_vec,
+            max_vec,
+            nan_count);
     l_store += (vtype::numlanes - amount_ge_pivot);
     unpartitioned -= vtype::numlanes;
 
-    amount_ge_pivot
-            = partition_vec<vtype, comparator>(arr + l_store,
-                                               arr + l_store + unpartitioned,
-                                               vec_right,
-                                               pivot_vec,
-                                               min_vec,
-                                               max_vec);
+    amount_ge_pivot = partition_vec<vtype, comparator, nan_mode>(
+            arr + l_store,
+            arr + l_store + unpartitioned,
+            vec_right,
+            pivot_vec,
+            min_vec,
+            max_vec,
+            nan_count);
     l_store += (vtype::numlanes - amount_ge_pivot);
     unpartitioned -= vtype::numlanes;
 
@@ -361,35 +516,32 @@ X86_SIMD_SORT_INLINE arrsize_t partition(type_t *arr,
 template <typename vtype,
           typename comparator,
           int num_unroll,
+          nan_mode_t nan_mode = nan_mode_t::none,
           typename type_t = typename vtype::type_t>
-X86_SIMD_SORT_INLINE arrsize_t partition_unrolled(type_t *arr,
-                                                  arrsize_t left,
-                                                  arrsize_t right,
-                                                  type_t pivot,
-                                                  type_t *smallest,
-                                                  type_t *biggest)
+X86_SIMD_SORT_INLINE arrsize_t
+partition_unrolled(type_t *arr,
+                   arrsize_t left,
+                   arrsize_t right,
+                   type_t pivot,
+                   type_t *smallest,
+                   type_t *biggest,
+                   arrsize_t *nan_count = nullptr)
 {
     if constexpr (num_unroll == 0) {
-        return partition<vtype, comparator>(
-                arr, left, right, pivot, smallest, biggest);
+        return partition<vtype, comparator, nan_mode>(
+                arr, left, right, pivot, smallest, biggest, nan_count);
     }
 
     /* Use regular partition for smaller arrays */
     if (right - left < 3 * num_unroll * vtype::numlanes) {
-        return partition<vtype, comparator>(
-                arr, left, right, pivot, smallest, biggest);
+        return partition<vtype, comparator, nan_mode>(
+                arr, left, right, pivot, smallest, biggest, nan_count);
     }
 
     /* make array length divisible by vtype::numlanes, shortening the array */
     for (int32_t i = ((right - left) % (vtype::numlanes)); i > 0; --i) {
-        *smallest = std::min(*smallest, arr[left], comparison_func<vtype>);
-        *biggest = std::max(*biggest, arr[left], comparison_func<vtype>);
-        if (!comparator::STDSortComparator(arr[left], pivot)) {
-            std::swap(arr[left], arr[--right]);
-        }
-        else {
-            ++left;
-        }
+        partition_scalar<vtype, comparator, nan_mode>(
+                arr, left, right, pivot, smallest, biggest, nan_count);
     }
 
     arrsize_t unpartitioned = right - left - vtype::numlanes;
@@ -466,13 +618,15 @@ X86_SIMD_SORT_INLINE arrsize_t partition_unrolled(type_t *arr,
          * */
         X86_SIMD_SORT_UNROLL_LOOP(8)
         for (int ii = 0; ii < num_unroll; ++ii) {
-            arrsize_t amount_ge_pivot = partition_vec<vtype, comparator>(
-                    arr + l_store,
-                    arr + l_store + unpartitioned,
-                    curr_vec[ii],
-                    pivot_vec,
-                    min_vec,
-                    max_vec);
+            arrsize_t amount_ge_pivot
+                    = partition_vec<vtype, comparator, nan_mode>(
+                            arr + l_store,
+                            arr + l_store + unpartitioned,
+                            curr_vec[ii],
+                            pivot_vec,
+                            min_vec,
+                            max_vec,
+                            nan_count);
             l_store += (vtype::numlanes - amount_ge_pivot);
             unpartitioned -= vtype::numlanes;
         }
@@ -481,25 +635,27 @@ X86_SIMD_SORT_INLINE arrsize_t partition_unrolled(type_t *arr,
     /* partition and save vec_left[num_unroll] and vec_right[num_unroll] */
     X86_SIMD_SORT_UNROLL_LOOP(8)
     for (int ii = 0; ii < num_unroll; ++ii) {
-        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator>(
+        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator, nan_mode>(
                 arr + l_store,
                 arr + l_store + unpartitioned,
                 vec_left[ii],
                 pivot_vec,
                 min_vec,
-                max_vec);
+                max_vec,
+                nan_count);
         l_store += (vtype::numlanes - amount_ge_pivot);
         unpartitioned -= vtype::numlanes;
     }
     X86_SIMD_SORT_UNROLL_LOOP(8)
     for (int ii = 0; ii < num_unroll; ++ii) {
-        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator>(
+        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator, nan_mode>(
                 arr + l_store,
                 arr + l_store + unpartitioned,
                 vec_right[ii],
                 pivot_vec,
                 min_vec,
-                max_vec);
+                max_vec,
+                nan_count);
         l_store += (vtype::numlanes - amount_ge_pivot);
         unpartitioned -= vtype::numlanes;
     }
@@ -507,13 +663,14 @@ X86_SIMD_SORT_INLINE arrsize_t partition_unrolled(type_t *arr,
     /* partition and save vec_align[vecsToPartition] */
     X86_SIMD_SORT_UNROLL_LOOP(8)
     for (int ii = 0; ii < vecsToPartition; ++ii) {
-        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator>(
+        arrsize_t amount_ge_pivot = partition_vec<vtype, comparator, nan_mode>(
                 arr + l_store,
                 arr + l_store + unpartitioned,
                 vec_align[ii],
                 pivot_vec,
                 min_vec,
-                max_vec);
+                max_vec,
+                nan_count);
         l_store += (vtype::numlanes - amount_ge_pivot);
         unpartitioned -= vtype::numlanes;
     }
@@ -604,6 +761,100 @@ static void qsort_(type_t *arr,
 #endif
 }
 
+/*
+ * Same recursion as qsort_, but every sub-array larger than task_threshold is
+ * handed to the executor as a separate job. The current thread keeps the
+ * right half and loops on it, so the partitioning of the large sub-arrays
+ * proceeds in parallel and each small enough sub-array is sorted by qsort_.
+ */
+template <typename vtype,
+          typename comparator,
+          typename type_t,
+          typename executor_t>
+static void qsort_parallel_(type_t *arr,
+                            arrsize_t left,
+                            arrsize_t right,
+                            arrsize_t max_iters,
+                            arrsize_t task_threshold,
+                            xss::task_group<executor_t> &tasks)
+{
+    while (right + 1 - left > task_threshold) {
+        if (max_iters <= 0) {
+            std::sort(arr + left,
+                      arr + right + 1,
+                      comparator::STDSortComparator);
+            return;
+        }
+
+        auto pivot_result
+                = get_pivot_smart<vtype, comparator, type_t>(arr, left, right);
+        type_t pivot = pivot_result.pivot;
+
+        if (pivot_result.result == pivot_result_t::Sorted) { return; }
+
+        type_t smallest = vtype::type_max();
+        type_t biggest = vtype::type_min();
+
+        arrsize_t pivot_index
+                = partition_unrolled<vtype,
+                                     comparator,
+                                     vtype::partition_unroll_factor>(
+                        arr, left, right + 1, pivot, &smallest, &biggest);
+
+        if (pivot_result.result == pivot_result_t::Only2Values) { return; }
+
+        type_t leftmostValue = comparator::leftmost(smallest, biggest);
+        type_t rightmostValue = comparator::rightmost(smallest, biggest);
+
+        if (pivot != leftmostValue) {
+            arrsize_t sub_right = pivot_index - 1;
+            tasks.run([=, &tasks]() {
+                qsort_parallel_<vtype, comparator>(arr,
+                                                   left,
+                                                   sub_right,
+                                                   max_iters - 1,
+                                                   task_threshold,
+                                                   tasks);
+            });
+        }
+        if (pivot == rightmostValue) { return; }
+        left = pivot_index;
+        max_iters = max_iters - 1;
+    }
+    qsort_<vtype, comparator>(arr,
+                              left,
+                              right,
+                              max_iters,
+                              std::numeric_limits<arrsize_t>::max());
+}
+
+/*
+ * Runs qsort_parallel_ on the executor and waits for it to finish; arrays too
+ * small to be worth splitting are sorted on the calling thread.
+ */
+template <typename vtype,
+          typename comparator,
+          typename type_t,
+          typename executor_t>
+X86_SIMD_SORT_INLINE void
+qsort_parallel_helper(type_t *arr, arrsize_t arrsize, executor_t &ex)
+{
+    arrsize_t max_iters = 2 * (arrsize_t)log2(arrsize);
+    if (arrsize <= 100000) {
+        qsort_<vtype, comparator, type_t>(arr,
+                                          0,
+                                          arrsize - 1,
+                                          max_iters,
+                                          std::numeric_limits<arrsize_t>::max());
+        return;
+    }
+    arrsize_t task_threshold = std::max((arrsize_t)100000, arrsize / 100);
+    xss::task_group<executor_t> tasks(ex);
+    qsort_parallel_<vtype, comparator, type_t>(
+            arr, 0, arrsize - 1, max_iters, task_threshold, tasks);
+    tasks.wait();
+}
+
 template <typename vtype, typename comparator, typename type_t>
 X86_SIMD_SORT_INLINE void qselect_(type_t *arr,
                                    arrsize_t pos,
@@ -649,6 +900,83 @@ X86_SIMD_SORT_INLINE void qselect_(type_t *arr,
 }
 
 // Quicksort routines:
+template <typename vtype, typename comparator, typename T>
+X86_SIMD_SORT_INLINE void qsort_toplevel_(T *arr, arrsize_t arrsize)
+{
+#ifdef XSS_COMPILE_OPENMP
+
+    bool use_parallel = arrsize > 100000;
+
+    if (use_parallel) {
+        int thread_count = xss_get_num_threads();
+        arrsize_t task_threshold = std::max((arrsize_t)100000, arrsize / 100);
+
+        // We use omp parallel and then omp single to setup the threads that will run the omp task calls in qsort_
+        // The omp single prevents multiple threads from running the initial qsort_ simultaneously and causing problems
+        // Note that we do not use the if(...) clause built into OpenMP, because it causes a performance regression for small arrays
+#pragma omp parallel num_threads(thread_count)
+#pragma omp single
+        qsort_<vtype, comparator, T>(arr,
+                                     0,
+                                     arrsize - 1,
+                                     2 * (arrsize_t)log2(arrsize),
+                                     task_threshold);
+#pragma omp taskwait
+    }
+    else {
+        qsort_<vtype, comparator, T>(arr,
+                                     0,
+                                     arrsize - 1,
+                                     2 * (arrsize_t)log2(arrsize),
+                                     std::numeric_limits<arrsize_t>::max());
+    }
+#else
+    qsort_<vtype, comparator, T>(
+            arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize), 0);
+#endif
+}
+
+/*
+ * Sorts a floating-point array that may hold NaNs. They are replaced by
+ * vtype::type_max() and counted in the first partition, rather than in a
+ * separate pass over the array. Returns false, with the NaNs replaced, if the
+ * array is small or goes to the presorted or radix paths, which the caller
+ * then has to run.
+ */
+template <typename vtype, typename comparator, typename T>
+X86_SIMD_SORT_INLINE bool
+qsort_with_nans_(T *arr, arrsize_t arrsize, arrsize_t *nan_count)
+{
+    if (arrsize <= vtype::network_sort_threshold || xss_use_radix<T>(arrsize)
+        || looks_presorted_<vtype, comparator>(arr, arrsize)) {
+        *nan_count = replace_nan_with_inf<vtype>(arr, arrsize);
+        return false;
+    }
+
+    T pivot = get_pivot_with_nans<vtype>(arr, 0, arrsize - 1);
+    T smallest = vtype::type_max();
+    T biggest = vtype::type_min();
+
+    arrsize_t pivot_index
+            = partition_unrolled<vtype,
+                                 comparator,
+                                 vtype::partition_unroll_factor,
+                                 nan_mode_t::replace>(
+                    arr, 0, arrsize, pivot, &smallest, &biggest, nan_count);
+
+    T leftmostValue = comparator::leftmost(smallest, biggest);
+    T rightmostValue = comparator::rightmost(smallest, biggest);
+
+    if (pivot != leftmostValue && pivot_index > 1) {
+        qsort_toplevel_<vtype, comparator, T>(arr, pivot_index);
+    }
+    if (pivot != rightmostValue && arrsize - pivot_index > 1) {
+        qsort_toplevel_<vtype, comparator, T>(arr + pivot_index,
+                                              arrsize - pivot_index);
+    }
+    return true;
+}
+
 template <typename vtype, typename T, bool descending = false>
 X86_SIMD_SORT_INLINE void xss_qsort(T *arr, arrsize_t arrsize, bool hasnan)
 {
@@ -659,46 +987,54 @@ X86_SIMD_SORT_INLINE void xss_qsort(T *arr, arrsize_t arrsize, bool hasnan)
 
     if (arrsize > 1) {
         arrsize_t nan_count = 0;
+        bool sorted = false;
         if constexpr (xss::fp::is_floating_point_v<T>) {
             if (UNLIKELY(hasnan)) {
-                nan_count = replace_nan_with_inf<vtype>(arr, arrsize);
+                sorted = qsort_with_nans_<vtype, comparator, T>(
+                        arr, arrsize, &nan_count);
             }
         }
 
         UNUSED(hasnan);
 
-#ifdef XSS_COMPILE_OPENMP
+        if (!sorted && !qsort_presorted_<vtype, comparator, T>(arr, arrsize)
+            && !xss_counting_qsort<vtype, T, descending>(arr, arrsize)
+            && !xss_radix_qsort<T, descending>(arr, arrsize)) {
+            qsort_toplevel_<vtype, comparator, T>(arr, arrsize);
+        }
+
+        replace_inf_with_nan(arr, arrsize, nan_count, descending);
+    }
 
-        bool use_parallel = arrsize > 100000;
+#ifdef __MMX__
+    // Workaround for compiler bug generating MMX instructions without emms
+    _mm_empty();
+#endif
+}
 
-        if (use_parallel) {
-            int thread_count = xss_get_num_threads();
-            arrsize_t task_threshold
-                    = std::max((arrsize_t)100000, arrsize / 100);
+// Multi-threaded quicksort on an executor (see xss-thread-pool.hpp):
+template <typename vtype,
+          typename T,
+          bool descending = false,
+          typename executor_t>
+X86_SIMD_SORT_INLINE void
+xss_qsort_parallel(T *arr, arrsize_t arrsize, bool hasnan, executor_t &ex)
+{
+    using comparator =
+            typename std::conditional<descending,
+                                      Comparator<vtype, true>,
+                                      Comparator<vtype, false>>::type;
 
-            // We use omp parallel and then omp single to setup the threads that will run the omp task calls in qsort_
-            // The omp single prevents multiple threads from running the initial qsort_ simultaneously and causing problems
-            // Note that we do not use the if(...) clause built into OpenMP, because it causes a performance regression for small arrays
-#pragma omp parallel num_threads(thread_count)
-#pragma omp single
-            qsort_<vtype, comparator, T>(arr,
-                                         0,
-                                         arrsize - 1,
-                                         2 * (arrsize_t)log2(arrsize),
-                                         task_threshold);
-#pragma omp taskwait
-        }
-        else {
-            qsort_<vtype, comparator, T>(arr,
-                                         0,
-                                         arrsize - 1,
-                                         2 * (arrsize_t)log2(arrsize),
-                                         std::numeric_limits<arrsize_t>::max());
+    if (arrsize > 1) {
+        arrsize_t nan_count = 0;
+        if constexpr (xss::fp::is_floating_point_v<T>) {
+            if (UNLIKELY(hasnan)) {
+                nan_count = replace_nan_with_inf<vtype>(arr, arrsize);
+            }
         }
-#else
-        qsort_<vtype, comparator, T>(
-                arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize), 0);
-#endif
+
+        UNUSED(hasnan);
+        qsort_parallel_helper<vtype, comparator, T>(arr, arrsize, ex);
 
         replace_inf_with_nan(arr, arrsize, nan_count, descending);
     }
@@ -709,6 +1045,54 @@ X86_SIMD_SORT_INLINE void xss_qsort(T *arr, arrsize_t arrsize, bool hasnan)
 #endif
 }
 
+/*
+ * Narrows a quickselect on a floating-point array that may hold NaNs to the
+ * range [*first, *end) that excludes them. The first partition moves the NaNs
+ * to the side of the pivot they sort to and counts them, so only the side
+ * that holds k has to be searched for them, and only if there are any.
+ * Returns false, leaving arr untouched, if the array is too small to be worth
+ * partitioning.
+ */
+template <typename vtype, typename comparator, typename T>
+X86_SIMD_SORT_INLINE bool qselect_nan_bounds_(T *arr,
+                                              arrsize_t k,
+                                              arrsize_t arrsize,
+                                              arrsize_t *first,
+                                              arrsize_t *end)
+{
+    if (arrsize <= vtype::network_sort_threshold) return false;
+
+    T pivot = get_pivot_with_nans<vtype>(arr, 0, arrsize - 1);
+    T smallest = vtype::type_max();
+    T biggest = vtype::type_min();
+    arrsize_t nan_count = 0;
+
+    arrsize_t pivot_index
+            = partition_unrolled<vtype,
+                                 comparator,
+                                 vtype::partition_unroll_factor,
+                                 nan_mode_t::route>(
+                    arr, 0, arrsize, pivot, &smallest, &biggest, &nan_count);
+
+    if (k < pivot_index) {
+        *first = 0;
+        *end = pivot_index;
+        if (comparator::is_descending && nan_count > 0) {
+            *first = move_nans_to_start_of_array<vtype>(arr, pivot_index);
+        }
+    }
+    else {
+        *first = pivot_index;
+        *end = arrsize;
+        if (!comparator::is_descending && nan_count > 0) {
+            *end = pivot_index + 1
+                    + move_nans_to_end_of_array<vtype>(arr + pivot_index,
+                                                       arrsize - pivot_index);
+        }
+    }
+    return true;
+}
+
 // Quick select methods
 template <typename vtype, typename T, bool descending = false>
 X86_SIMD_SORT_INLINE void
@@ -723,25 +1107,28 @@ xss_qselect(T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan)
     if (arrsize <= 1) return;
 
     arrsize_t index_first_elem = 0;
-    arrsize_t index_last_elem = arrsize - 1;
+    arrsize_t index_end = arrsize;
 
     if constexpr (xss::fp::is_floating_point_v<T>) {
-        if (UNLIKELY(hasnan)) {
+        if (UNLIKELY(hasnan)
+            && !qselect_nan_bounds_<vtype, comparator, T>(
+                    arr, k, arrsize, &index_first_elem, &index_end)) {
             if constexpr (descending) {
-                index_first_elem = move_nans_to_start_of_array(arr, arrsize);
+                index_first_elem
+                        = move_nans_to_start_of_array<vtype>(arr, arrsize);
             }
             else {
-                index_last_elem = move_nans_to_end_of_array(arr, arrsize);
+                index_end = move_nans_to_end_of_array<vtype>(arr, arrsize) + 1;
             }
         }
     }
 
     UNUSED(hasnan);
-    if (index_first_elem <= k && index_last_elem >= k) {
+    if (index_first_elem <= k && k < index_end) {
         qselect_<vtype, comparator, T>(arr,
                                        k,
                                        index_first_elem,
-                                       index_last_elem,
+                                       index_end - 1,
                                        2 * (arrsize_t)log2(arrsize));
     }
 
@@ -751,16 +1138,231 @@ xss_qselect(T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan)
 #endif
 }
 
+/*
+ * Top-k filter used by the partial sorts when k is much smaller than the array.
+ * The best k candidates seen so far are kept at the start of the array and
+ * every vector of the input is compared against the worst of them (the
+ * threshold), so most of the array is rejected with one compare per vector and
+ * never written. A candidate is swapped into the prefix, which keeps the array
+ * a permutation of the input. Once the prefix is full it is reduced back to
+ * the best k with select(), which tightens the threshold.
+ *
+ * Returns the length of the prefix that holds the best k elements. If the
+ * input keeps producing candidates (e.g. it is sorted in the opposite order)
+ * the filter gives up and returns arrsize, so the caller selects over the
+ * whole array as it would have without the filter.
+ */
+constexpr arrsize_t xss_topk_max_k = 1024;
+constexpr arrsize_t xss_topk_min_ratio = 64;
+
+X86_SIMD_SORT_INLINE bool xss_use_topk(arrsize_t k, arrsize_t arrsize)
+{
+    return k <= xss_topk_max_k && arrsize / xss_topk_min_ratio >= k;
+}
+
+template <typename vtype,
+          typename comparator,
+          typename T,
+          typename SwapFunc,
+          typename SelectFunc>
+X86_SIMD_SORT_INLINE arrsize_t topk_filter_(T *arr,
+                                            arrsize_t k,
+                                            arrsize_t arrsize,
+                                            SwapFunc swap,
+                                            SelectFunc select)
+{
+    using reg_t = typename vtype::reg_t;
+    const arrsize_t capacity = 2 * k + 4 * vtype::numlanes;
+    const arrsize_t max_candidates = arrsize / 64;
+
+    T threshold = arr[0];
+    for (arrsize_t ii = 1; ii < k; ++ii) {
+        if (comparator::STDSortComparator(threshold, arr[ii])) {
+            threshold = arr[ii];
+        }
+    }
+    reg_t threshold_vec = vtype::set1(threshold);
+    arrsize_t num_best = k;
+    arrsize_t num_candidates = 0;
+
+    arrsize_t ii = k;
+    for (; ii + vtype::numlanes <= arrsize; ii += vtype::numlanes) {
+        reg_t in = vtype::loadu(arr + ii);
+        auto better = vtype::knot_opmask(
+                comparator::PartitionComparator(in, threshold_vec));
+        if (LIKELY(vtype::all_false(better))) continue;
+
+        for (int jj = 0; jj < vtype::numlanes; ++jj) {
+            if (comparator::STDSortComparator(arr[ii + jj], threshold)) {
+                swap(num_best++, ii + jj);
+            }
+        }
+        if (num_best >= capacity) {
+            num_candidates += num_best - k;
+            if (num_candidates > max_candidates) return arrsize;
+            select(num_best);
+            threshold = arr[k - 1];
+            threshold_vec = vtype::set1(threshold);
+            num_best = k;
+        }
+    }
+    for (; ii < arrsize; ++ii) {
+        if (comparator::STDSortComparator(arr[ii], threshold)) {
+            swap(num_best++, ii);
+        }
+    }
+    return num_best;
+}
+
 // Partial sort methods:
 template <typename vtype, typename T, bool descending = false>
 X86_SIMD_SORT_INLINE void
 xss_partial_qsort(T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan)
 {
     if (k == 0) return;
+    // NaNs fail every compare against the threshold, so skip the filter
+    if (!hasnan && xss_use_topk(k, arrsize)) {
+        using comparator =
+                typename std::conditional<descending,
+                                          Comparator<vtype, true>,
+                                          Comparator<vtype, false>>::type;
+        arrsize = topk_filter_<vtype, comparator>(
+                arr,
+                k,
+                arrsize,
+                [arr](arrsize_t ii, arrsize_t jj) {
+                    std::swap(arr[ii], arr[jj]);
+                },
+                [arr, k](arrsize_t size) {
+                    xss_qselect<vtype, T, descending>(arr, k - 1, size, false);
+                });
+    }
     xss_qselect<vtype, T, descending>(arr, k - 1, arrsize, hasnan);
     xss_qsort<vtype, T, descending>(arr, k - 1, hasnan);
 }
 
+/*
+ * Copies the elements of arr that are strictly better than threshold (smaller,
+ * or larger when descending) to out and returns how many it copied. Every
+ * vector is tested with one compare and only the vectors that hold a candidate
+ * are compress-stored, so a stream that rarely beats the threshold costs about
+ * one load and compare per vector. NaNs are never copied. out must have room
+ * for arrsize elements.
+ */
+template <typename vtype, typename comparator, typename T>
+X86_SIMD_SORT_INLINE arrsize_t topk_filter_copy_(const T *arr,
+                                                 arrsize_t arrsize,
+                                                 T threshold,
+                                                 T *out)
+{
+    using reg_t = typename vtype::reg_t;
+    reg_t threshold_vec = vtype::set1(threshold);
+    T rejected[vtype::numlanes];
+    arrsize_t count = 0;
+
+    arrsize_t ii = 0;
+    for (; ii + vtype::numlanes <= arrsize; ii += vtype::numlanes) {
+        reg_t in = vtype::loadu(arr + ii);
+        auto ge = comparator::PartitionComparator(in, threshold_vec);
+        if (LIKELY(vtype::all_false(vtype::knot_opmask(ge)))) continue;
+
+        // The lanes that fail the compare are the candidates, together with
+        // any NaNs, which the scalar check drops again
+        int num_rejected
+                = vtype::double_compressstore(out + count, rejected, ge, in);
+        arrsize_t end = count + vtype::numlanes - num_rejected;
+        for (arrsize_t jj = count; jj < end; ++jj) {
+            if (comparator::STDSortComparator(out[jj], threshold)) {
+                out[count++] = out[jj];
+            }
+        }
+    }
+    for (; ii < arrsize; ++ii) {
+        if (comparator::STDSortComparator(arr[ii], threshold)) {
+            out[count++] = arr[ii];
+        }
+    }
+    return count;
+}
+
+template <typename vtype, typename T, bool descending = false>
+X86_SIMD_SORT_INLINE arrsize_t
+xss_topk_filter(const T *arr, arrsize_t arrsize, T threshold, T *out)
+{
+    using comparator =
+            typename std::conditional<descending,
+                                      Comparator<vtype, true>,
+                                      Comparator<vtype, false>>::type;
+
+    arrsize_t count = topk_filter_copy_<vtype, comparator>(
+            arr, arrsize, threshold, out);
+
+#ifdef __MMX__
+    // Workaround for compiler bug generating MMX instructions without emms
+    _mm_empty();
+#endif
+    return count;
+}
+
+// Batched sort of many small independent arrays:
+template <typename vtype, typename comparator, typename T>
+X86_SIMD_SORT_INLINE void qsort_segment_(T *arr, arrsize_t size)
+{
+    /*
+     * Segments that fit in the bitonic networks go straight to them and skip
+     * the quicksort setup
+     */
+    if (size <= vtype::network_sort_threshold) {
+        sort_n<vtype, comparator, vtype::network_sort_threshold>(
+                arr, (int32_t)size);
+    }
+    else {
+        qsort_<vtype, comparator, T>(arr,
+                                     0,
+                                     size - 1,
+                                     2 * (arrsize_t)log2(size),
+                                     std::numeric_limits<arrsize_t>::max());
+    }
+}
+
+/*
+ * Sorts every segment arr[offsets[ii]] ... arr[offsets[ii + 1] - 1] for
+ * 0 <= ii < num_segments, offsets holds num_segments + 1 entries
+ */
+template <typename vtype, typename T, bool descending = false>
+X86_SIMD_SORT_INLINE void xss_qsort_segments(T *arr,
+                                             const arrsize_t *offsets,
+                                             arrsize_t num_segments,
+                                             bool hasnan)
+{
+    using comparator =
+            typename std::conditional<descending,
+                                      Comparator<vtype, true>,
+                                      Comparator<vtype, false>>::type;
+
+    for (arrsize_t ii = 0; ii < num_segments; ++ii) {
+        T *seg = arr + offsets[ii];
+        arrsize_t size = offsets[ii + 1] - offsets[ii];
+        if (size <= 1) continue;
+
+        arrsize_t nan_count = 0;
+        if constexpr (xss::fp::is_floating_point_v<T>) {
+            if (UNLIKELY(hasnan)) {
+                nan_count = replace_nan_with_inf<vtype>(seg, size);
+            }
+        }
+        qsort_segment_<vtype, comparator, T>(seg, size);
+        replace_inf_with_nan(seg, size, nan_count, descending);
+    }
+
+    UNUSED(hasnan);
+
+#ifdef __MMX__
+    // Workaround for compiler bug generating MMX instructions without emms
+    _mm_empty();
+#endif
+}
+
 #define DEFINE_METHODS(ISA, VTYPE) \
     template <typename T> \
     X86_SIMD_SORT_INLINE void ISA##_qsort(T *arr, \
@@ -773,6 +1375,20 @@ xss_partial_qsort(T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan)
             xss_qsort<VTYPE, T, false>(arr, size, hasnan); \
         } \
     } \
+    template <typename T, typename executor_t> \
+    X86_SIMD_SORT_INLINE void ISA##_qsort_parallel(T *arr, \
+                                                   arrsize_t size, \
+                                                   executor_t &ex, \
+                                                   bool hasnan = false, \
+                                                   bool descending = false) \
+    { \
+        if (descending) { \
+            xss_qsort_parallel<VTYPE, T, true>(arr, size, hasnan, ex); \
+        } \
+        else { \
+            xss_qsort_parallel<VTYPE, T, false>(arr, size, hasnan, ex); \
+        } \
+    } \
     template <typename T> \
     X86_SIMD_SORT_INLINE void ISA##_qselect(T *arr, \
                                             arrsize_t k, \
@@ -798,6 +1414,39 @@ xss_partial_qsort(T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan)
         else { \
             xss_partial_qsort<VTYPE, T, false>(arr, k, size, hasnan); \
         } \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE void ISA##_qsort_segments( \
+            T *arr, \
+            const arrsize_t *offsets, \
+            arrsize_t num_segments, \
+            bool hasnan = false, \
+            bool descending = false) \
+    { \
+        if (descending) { \
+            xss_qsort_segments<VTYPE, T, true>( \
+                    arr, offsets, num_segments, hasnan); \
+        } \
+        else { \
+            xss_qsort_segments<VTYPE, T, false>( \
+                    arr, offsets, num_segments, hasnan); \
+        } \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE arrsize_t ISA##_topk_filter(const T *arr, \
+                                                     arrsize_t size, \
+                                                     T threshold, \
+                                                     T *out, \
+                                                     bool descending = false) \
+    { \
+        if (descending) { \
+            return xss_topk_filter<VTYPE, T, true>( \
+                    arr, size, threshold, out); \
+        } \
+        else { \
+            return xss_topk_filter<VTYPE, T, false>( \
+                    arr, size, threshold, out); \
+        } \
     }
 
 DEFINE_METHODS(avx512, zmm_vector<T>)
@@ -0,0 +1,151 @@
+#ifndef XSS_COUNTING_SORT
+#define XSS_COUNTING_SORT
+
+#include "xss-common-includes.h"
+#include <memory>
+#include <new>
+
+/*
+ * Counting sort for integer arrays that hold a narrow range of values, which
+ * covers every large enough 16-bit array. One vectorized pass finds the
+ * minimum and maximum, a second one counts how often each value in between
+ * occurs, and the array is then rewritten front to back with runs of equal
+ * values. The quicksort needs about log2(range) partitioning passes over such
+ * arrays, the counting sort two reads and one sequential write.
+ *
+ * It is only used when the range spans at least xss_count_min_range values:
+ * below that the quicksort already finishes in a few passes and the serial
+ * increments of the histogram lose to it on large arrays. The array has to
+ * hold at least four times as many elements as the range, so that clearing
+ * and walking the table does not dominate, and the table of uint32_t counts
+ * is capped at xss_count_max_range entries to stay in L2.
+ */
+constexpr arrsize_t xss_count_min_range = 128;
+constexpr arrsize_t xss_count_max_range = 1 << 16;
+
+X86_SIMD_SORT_INLINE bool xss_use_counting(arrsize_t range, arrsize_t arrsize)
+{
+    return range >= xss_count_min_range && range <= xss_count_max_range
+            && range <= arrsize / 4;
+}
+
+/* Number of values from min to max, saturated at arrsize_t's maximum */
+template <typename T>
+X86_SIMD_SORT_FINLINE arrsize_t xss_count_range(T min, T max)
+{
+    using utype = typename std::make_unsigned<T>::type;
+    utype diff = (utype)max - (utype)min;
+    if (diff >= std::numeric_limits<arrsize_t>::max()) {
+        return std::numeric_limits<arrsize_t>::max();
+    }
+    return (arrsize_t)diff + 1;
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void
+xss_count_minmax(T *arr, arrsize_t arrsize, T *smallest, T *biggest)
+{
+    using reg_t = typename vtype::reg_t;
+    T min = arr[0], max = arr[0];
+    arrsize_t ii = 0;
+    if (arrsize >= vtype::numlanes) {
+        reg_t min_vec = vtype::loadu(arr);
+        reg_t max_vec = min_vec;
+        for (; ii + vtype::numlanes <= arrsize; ii += vtype::numlanes) {
+            reg_t v = vtype::loadu(arr + ii);
+            min_vec = vtype::min(min_vec, v);
+            max_vec = vtype::max(max_vec, v);
+        }
+        min = vtype::reducemin(min_vec);
+        max = vtype::reducemax(max_vec);
+    }
+    for (; ii < arrsize; ++ii) {
+        min = std::min(min, arr[ii]);
+        max = std::max(max, arr[ii]);
+    }
+    *smallest = min;
+    *biggest = max;
+}
+
+/*
+ * Counting sorts arr if its values span a range that pays off. Returns false
+ * if the caller has to quicksort it instead. The range of a sample of the
+ * array has to be close to the accepted one before the full minimum/maximum
+ * pass is made, which costs as much as the whole quicksort of an array with
+ * just a few distinct values.
+ */
+template <typename vtype, typename T, bool descending>
+X86_SIMD_SORT_INLINE bool xss_counting_qsort(T *arr, arrsize_t arrsize)
+{
+    if constexpr (xss::fp::is_floating_point_v<T>) {
+        return false;
+    }
+    else {
+        using utype = typename std::make_unsigned<T>::type;
+        constexpr arrsize_t num_samples = 64;
+        if (arrsize < 4 * xss_count_min_range
+            || arrsize > std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+#ifdef XSS_COMPILE_OPENMP
+        // such arrays are quicksorted on several threads instead
+        if (arrsize > 100000 && xss_get_num_threads() > 1) return false;
+#endif
+        T min = arr[0], max = arr[0];
+        arrsize_t stride = arrsize / num_samples;
+        for (arrsize_t ii = 0; ii < num_samples; ++ii) {
+            min = std::min(min, arr[ii * stride]);
+            max = std::max(max, arr[ii * stride]);
+        }
+        arrsize_t range = xss_count_range(min, max);
+        if (range < xss_count_min_range / 2 || range > xss_count_max_range
+            || range > arrsize / 4) {
+            return false;
+        }
+
+        xss_count_minmax<vtype>(arr, arrsize, &min, &max);
+        range = xss_count_range(min, max);
+        if (!xss_use_counting(range, arrsize)) return false;
+
+        std::unique_ptr<uint32_t[]> counts(new (std::nothrow)
+                                                   uint32_t[range]());
+        if (!counts) return false;
+        for (arrsize_t ii = 0; ii < arrsize; ++ii) {
+            counts[(utype)((utype)arr[ii] - (utype)min)]++;
+        }
+
+        /*
+         * Runs are written with whole vectors and may spill past their end,
+         * the next run overwrites the spill. Near the end of the array the
+         * rest is written one element at a time.
+         */
+        T *out = arr;
+        T *end = arr + arrsize;
+        arrsize_t bucket = 0;
+        for (; bucket < range && out + vtype::numlanes <= end; ++bucket) {
+            arrsize_t idx = descending ? range - 1 - bucket : bucket;
+            arrsize_t count = counts[idx];
+            T value = (T)((utype)min + (utype)idx);
+            typename vtype::reg_t v = vtype::set1(value);
+            arrsize_t ii = 0;
+            for (; ii < count && out + ii + vtype::numlanes <= end;
+                 ii += vtype::numlanes) {
+                vtype::storeu(out + ii, v);
+            }
+            for (; ii < count; ++ii) {
+                out[ii] = value;
+            }
+            out += count;
+        }
+        for (; bucket < range; ++bucket) {
+            arrsize_t idx = descending ? range - 1 - bucket : bucket;
+            T value = (T)((utype)min + (utype)idx);
+            for (arrsize_t ii = 0; ii < counts[idx]; ++ii) {
+                *out++ = value;
+            }
+        }
+        return true;
+    }
+}
+
+#endif // XSS_COUNTING_SORT
@@ -85,6 +85,54 @@ namespace fp {
     }
 #endif
 
+#ifdef __BFLT16_MAX__
+    typedef union {
+        __bf16 f_;
+        uint16_t i_;
+    } Bf16Bits;
+
+    static __bf16 convert_bf16_bits(uint16_t val)
+    {
+        Bf16Bits temp;
+        temp.i_ = val;
+        return temp.f_;
+    }
+
+    template <>
+    [[maybe_unused]] inline constexpr bool is_floating_point_v<__bf16> = true;
+
+    template <>
+    [[maybe_unused]] bool isnan<__bf16>(__bf16 elem)
+    {
+        return elem != elem;
+    }
+    template <>
+    [[maybe_unused]] bool isunordered<__bf16>(__bf16 a, __bf16 b)
+    {
+        return isnan(a) || isnan(b);
+    }
+    template <>
+    [[maybe_unused]] __bf16 max<__bf16>()
+    {
+        return convert_bf16_bits(0x7f7f);
+    }
+    template <>
+    [[maybe_unused]] __bf16 min<__bf16>()
+    {
+        return convert_bf16_bits(0x0080);
+    }
+    template <>
+    [[maybe_unused]] __bf16 infinity<__bf16>()
+    {
+        return convert_bf16_bits(0x7f80);
+    }
+    template <>
+    [[maybe_unused]] __bf16 quiet_NaN<__bf16>()
+    {
+        return convert_bf16_bits(0x7fc0);
+    }
+#endif
+
 } // namespace fp
 } // namespace xss
 #endif // XSS_CUSTOM_FLOAT
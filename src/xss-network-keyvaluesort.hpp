@@ -206,9 +206,33 @@ bitonic_fullmerge_n_vec(typename keyType::reg_t *keys,
     }
 }
 
-template <typename keyType, typename indexType, int numVecs>
+/*
+ * Gathers the keys for one register of indices: arg points to the indices and
+ * arg_vec holds the same indices already loaded. 64-bit indices are gathered
+ * element by element, 32-bit indices use the hardware gather instructions.
+ * Note that those sign extend the index, which limits it to INT32_MAX.
+ */
+template <typename vtype, typename argtype, typename type_t, typename arg_t>
+X86_SIMD_SORT_INLINE typename vtype::reg_t
+arg_gather(type_t *arr, arg_t *arg, typename argtype::reg_t arg_vec)
+{
+    if constexpr (sizeof(arg_t) == sizeof(uint64_t)) {
+        UNUSED(arg_vec);
+        return vtype::i64gather(arr, arg);
+    }
+    else {
+        UNUSED(arg);
+        return vtype::template mask_i64gather<sizeof(type_t)>(
+                vtype::zmm_max(),
+                vtype::get_partial_loadmask(vtype::numlanes),
+                arg_vec,
+                arr);
+    }
+}
+
+template <typename keyType, typename indexType, int numVecs, typename arg_t>
 X86_SIMD_SORT_INLINE void
-argsort_n_vec(typename keyType::type_t *keys, arrsize_t *indices, int N)
+argsort_n_vec(typename keyType::type_t *keys, arg_t *indices, int N)
 {
     using kreg_t = typename keyType::reg_t;
     using ireg_t = typename indexType::reg_t;
@@ -238,8 +262,8 @@ argsort_n_vec(typename keyType::type_t *keys, arrsize_t *indices, int N)
     X86_SIMD_SORT_UNROLL_LOOP(64)
     for (int i = 0; i < numVecs / 2; i++) {
         indexVecs[i] = indexType::loadu(indices + i * indexType::numlanes);
-        keyVecs[i]
-                = keyType::i64gather(keys, indices + i * indexType::numlanes);
+        keyVecs[i] = arg_gather<keyType, indexType>(
+                keys, indices + i * indexType::numlanes, indexVecs[i]);
     }
     // Masked part of the load
     X86_SIMD_SORT_UNROLL_LOOP(64)
@@ -280,7 +304,10 @@ argsort_n_vec(typename keyType::type_t *keys, arrsize_t *indices, int N)
     }
 }
 
-template <typename keyType, typename valueType, int numVecs>
+template <typename keyType,
+          typename valueType,
+          typename comparator,
+          int numVecs>
 X86_SIMD_SORT_INLINE void kvsort_n_vec(typename keyType::type_t *keys,
                                        typename valueType::type_t *values,
                                        int N)
@@ -291,7 +318,8 @@ X86_SIMD_SORT_INLINE void kvsort_n_vec(typename keyType::type_t *keys,
     static_assert(numVecs > 0, "numVecs should be > 0");
     if constexpr (numVecs > 1) {
         if (N * 2 <= numVecs * keyType::numlanes) {
-            kvsort_n_vec<keyType, valueType, numVecs / 2>(keys, values, N);
+            kvsort_n_vec<keyType, valueType, comparator, numVecs / 2>(
+                    keys, values, N);
             return;
         }
     }
@@ -335,6 +363,37 @@ X86_SIMD_SORT_INLINE void kvsort_n_vec(typename keyType::type_t *keys,
     // Run the full merger
     bitonic_fullmerge_n_vec<keyType, valueType, numVecs>(keyVecs, valueVecs);
 
+    /*
+     * The registers now hold the N elements in ascending order. For a
+     * descending sort the full registers are reversed and stored back to
+     * front, and the one partially filled register goes to the start of the
+     * array, where its few elements are reversed in place. This replaces a
+     * separate pass to reverse the whole sorted array.
+     */
+    if constexpr (comparator::is_descending) {
+        X86_SIMD_SORT_UNROLL_LOOP(64)
+        for (int i = 0; i < numVecs; i++) {
+            int num_valid = std::min(std::max(0, N - i * keyType::numlanes),
+                                     (int)keyType::numlanes);
+            if (num_valid == keyType::numlanes) {
+                arrsize_t pos = N - (i + 1) * keyType::numlanes;
+                keyType::storeu(keys + pos, keyType::reverse(keyVecs[i]));
+                valueType::storeu(values + pos,
+                                  valueType::reverse(valueVecs[i]));
+            }
+            else if (num_valid > 0) {
+                auto mask = keyType::get_partial_loadmask(num_valid);
+                keyType::mask_storeu(keys, mask, keyVecs[i]);
+                valueType::mask_storeu(values,
+                                       resize_mask<keyType, valueType>(mask),
+                                       valueVecs[i]);
+                std::reverse(keys, keys + num_valid);
+                std::reverse(values, values + num_valid);
+            }
+        }
+        return;
+    }
+
     // Unmasked part of the store
     X86_SIMD_SORT_UNROLL_LOOP(64)
     for (int i = 0; i < numVecs / 2; i++) {
@@ -352,9 +411,9 @@ X86_SIMD_SORT_INLINE void kvsort_n_vec(typename keyType::type_t *keys,
     }
 }
 
-template <typename keyType, typename indexType, int maxN>
+template <typename keyType, typename indexType, int maxN, typename arg_t>
 X86_SIMD_SORT_INLINE void
-argsort_n(typename keyType::type_t *keys, arrsize_t *indices, int N)
+argsort_n(typename keyType::type_t *keys, arg_t *indices, int N)
 {
     static_assert(keyType::numlanes == indexType::numlanes,
                   "invalid pairing of value/index types");
@@ -368,7 +427,7 @@ argsort_n(typename keyType::type_t *keys, arrsize_t *indices, int N)
     argsort_n_vec<keyType, indexType, numVecs>(keys, indices, N);
 }
 
-template <typename keyType, typename valueType, int maxN>
+template <typename keyType, typename valueType, typename comparator, int maxN>
 X86_SIMD_SORT_INLINE void kvsort_n(typename keyType::type_t *keys,
                                    typename valueType::type_t *values,
                                    int N)
@@ -382,7 +441,7 @@ X86_SIMD_SORT_INLINE void kvsort_n(typename keyType::type_t *keys,
     static_assert(powerOfTwo == true && isMultiple == true,
                   "maxN must be keyType::numlanes times a power of 2");
 
-    kvsort_n_vec<keyType, valueType, numVecs>(keys, values, N);
+    kvsort_n_vec<keyType, valueType, comparator, numVecs>(keys, values, N);
 }
 
 #endif
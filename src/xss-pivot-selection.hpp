@@ -152,6 +152,38 @@ get_pivot_smart(type_t *arr, const arrsize_t left, const arrsize_t right)
     return pivot_results<type_t>(median);
 }
 
+/*
+ * Median of the same sample as get_pivot_smart, for an array that may hold
+ * NaNs: they are counted as vtype::type_max() so they never become the pivot
+ * unless most of the sample is NaN.
+ */
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE type_t get_pivot_with_nans(type_t *arr,
+                                                const arrsize_t left,
+                                                const arrsize_t right)
+{
+    using reg_t = typename vtype::reg_t;
+    constexpr int numVecs = 4;
+    constexpr int N = numVecs * vtype::numlanes;
+
+    arrsize_t width = (right - vtype::numlanes) - left;
+    arrsize_t delta = width / numVecs;
+
+    reg_t vecs[numVecs];
+    for (int i = 0; i < numVecs; i++) {
+        vecs[i] = vtype::loadu(arr + left + delta * i);
+        auto nanmask = vtype::template fpclass<0x01 | 0x80>(vecs[i]);
+        vecs[i] = vtype::mask_mov(vecs[i], nanmask, vtype::zmm_max());
+    }
+    sort_vectors<vtype, Comparator<vtype, false>, numVecs>(vecs);
+
+    type_t samples[N];
+    for (int i = 0; i < numVecs; i++) {
+        vtype::storeu(samples + vtype::numlanes * i, vecs[i]);
+    }
+    return samples[N / 2];
+}
+
 // Handles the case where we seem to have a near-constant array, since our sample of the array was constant
 template <typename vtype, typename comparator, typename type_t>
 X86_SIMD_SORT_INLINE pivot_results<type_t>
@@ -0,0 +1,345 @@
+#ifndef XSS_PRESORTED
+#define XSS_PRESORTED
+
+#include <memory>
+#include <new>
+
+/*
+ * Adaptive path of xss_qsort for input that is mostly in order already, such
+ * as a time series with a few late appends. The array is split into maximal
+ * runs that are in sort order or in reverse order. Runs of at least
+ * arrsize / xss_presorted_run_div elements are kept, reverse runs are
+ * reversed in place, and whatever lies between them is quicksorted. Then the
+ * pieces are merged two at a time with vectors, see merge_vectors_. A sorted
+ * array takes one read pass, an array with a short unordered tail about
+ * three.
+ *
+ * Input that is not made of a few long runs goes to the quicksort: there can
+ * be at most xss_presorted_max_pieces pieces, and unordered ones can cover at
+ * most a quarter of the array. Small windows spread over the array have to be
+ * in order (either way) before the full scan starts, which turns away random
+ * input at the cost of a few vector loads.
+ */
+constexpr arrsize_t xss_presorted_min_size = 1024;
+constexpr arrsize_t xss_presorted_run_div = 16;
+constexpr int xss_presorted_max_pieces = 8;
+constexpr int xss_presorted_windows = 16;
+
+template <typename vtype, typename comparator, typename type_t>
+static void qsort_(type_t *arr,
+                   arrsize_t left,
+                   arrsize_t right,
+                   arrsize_t max_iters,
+                   arrsize_t task_threshold);
+
+/* End of the run in comparator order that starts at arr[start] */
+template <typename vtype, typename comparator, typename type_t>
+X86_SIMD_SORT_INLINE arrsize_t run_end_(type_t *arr,
+                                        arrsize_t start,
+                                        arrsize_t arrsize)
+{
+    arrsize_t ii = start;
+    for (; ii + vtype::numlanes < arrsize; ii += vtype::numlanes) {
+        typename vtype::reg_t cur = vtype::loadu(arr + ii);
+        typename vtype::reg_t next = vtype::loadu(arr + ii + 1);
+        auto out_of_order = vtype::knot_opmask(
+                comparator::PartitionComparator(next, cur));
+        // the scalar loop below finds the element
+        if (!vtype::all_false(out_of_order)) break;
+    }
+    for (; ii + 1 < arrsize; ++ii) {
+        if (comparator::STDSortComparator(arr[ii + 1], arr[ii])) {
+            return ii + 1;
+        }
+    }
+    return arrsize;
+}
+
+/*
+ * Start of the first numlanes + 1 elements at or after arr[start] that are in
+ * order either way, or arrsize if there are none
+ */
+template <typename vtype, typename comparator, typename type_t>
+X86_SIMD_SORT_INLINE arrsize_t skip_unordered_(type_t *arr,
+                                               arrsize_t start,
+                                               arrsize_t arrsize)
+{
+    using reverse_comparator = Comparator<vtype, !comparator::is_descending>;
+    for (arrsize_t ii = start; ii + vtype::numlanes < arrsize;
+         ii += vtype::numlanes) {
+        typename vtype::reg_t cur = vtype::loadu(arr + ii);
+        typename vtype::reg_t next = vtype::loadu(arr + ii + 1);
+        if (vtype::all_false(vtype::knot_opmask(
+                    comparator::PartitionComparator(next, cur)))
+            || vtype::all_false(vtype::knot_opmask(
+                    reverse_comparator::PartitionComparator(next, cur)))) {
+            return ii;
+        }
+    }
+    return arrsize;
+}
+
+/*
+ * Merges two sorted inputs a vector at a time: the next vector of whichever
+ * input comes first goes through a bitonic merge with the upper half of the
+ * last one, and the lower half is written out. Going backward the inputs are
+ * read and out is written from their ends, with the order reversed. Stops
+ * when the input to read next has less than a vector left, and leaves the
+ * upper half of the last merge in last, in sort order.
+ */
+template <typename vtype, typename comparator, bool backward, typename type_t>
+X86_SIMD_SORT_INLINE void merge_vectors_(type_t *&aptr,
+                                         type_t *aend,
+                                         type_t *&bptr,
+                                         type_t *bend,
+                                         type_t *&out,
+                                         type_t *last)
+{
+    using reg_t = typename vtype::reg_t;
+    using swizzle = typename vtype::swizzle_ops;
+    using merge_comparator
+            = Comparator<vtype, comparator::is_descending != backward>;
+    constexpr int numlanes = vtype::numlanes;
+    auto load = [](type_t *&ptr) {
+        if constexpr (backward) {
+            ptr -= numlanes;
+            return swizzle::template reverse_n<vtype, numlanes>(
+                    vtype::loadu(ptr));
+        }
+        else {
+            ptr += numlanes;
+            return vtype::loadu(ptr - numlanes);
+        }
+    };
+    auto left = [](type_t *ptr, type_t *end) {
+        return backward ? ptr - end : end - ptr;
+    };
+
+    reg_t lower = load(aptr);
+    reg_t upper = load(bptr);
+    while (true) {
+        upper = swizzle::template reverse_n<vtype, numlanes>(upper);
+        merge_comparator::COEX(lower, upper);
+        internal_merge_n_vec<vtype, merge_comparator, 1, numlanes, false>(
+                &lower);
+        internal_merge_n_vec<vtype, merge_comparator, 1, numlanes, false>(
+                &upper);
+        if constexpr (backward) {
+            out -= numlanes;
+            vtype::storeu(out,
+                          swizzle::template reverse_n<vtype, numlanes>(lower));
+        }
+        else {
+            vtype::storeu(out, lower);
+            out += numlanes;
+        }
+        bool take_b = left(aptr, aend) == 0;
+        if (!take_b && left(bptr, bend) > 0) {
+            take_b = backward
+                    ? comparator::STDSortComparator(aptr[-1], bptr[-1])
+                    : comparator::STDSortComparator(*bptr, *aptr);
+        }
+        if (take_b) {
+            if (left(bptr, bend) < numlanes) break;
+            lower = load(bptr);
+        }
+        else {
+            if (left(aptr, aend) < numlanes) break;
+            lower = load(aptr);
+        }
+    }
+    if constexpr (backward) {
+        upper = swizzle::template reverse_n<vtype, numlanes>(upper);
+    }
+    vtype::storeu(last, upper);
+}
+
+/*
+ * Merges the sorted pieces [arr + left, arr + mid) and [arr + mid, arr +
+ * right), using buf to hold the shorter one. Pieces of similar size are
+ * merged with vectors. A piece that is much shorter than the other is merged
+ * by binary searching where each of its elements goes, and moving the
+ * elements of the longer piece in between as one block.
+ */
+template <typename vtype, typename comparator, typename type_t>
+X86_SIMD_SORT_INLINE void merge_pieces_(type_t *arr,
+                                        arrsize_t left,
+                                        arrsize_t mid,
+                                        arrsize_t right,
+                                        type_t *buf)
+{
+    constexpr int numlanes = vtype::numlanes;
+    auto comp = comparator::STDSortComparator;
+
+    // elements of either piece that are already in place
+    left = std::upper_bound(arr + left, arr + mid, arr[mid], comp) - arr;
+    right = std::lower_bound(arr + mid, arr + right, arr[mid - 1], comp) - arr;
+    if (left == mid || mid == right) return;
+
+    arrsize_t lsize = mid - left, rsize = right - mid;
+    bool blocks = lsize * 16 < rsize || rsize * 16 < lsize
+            || std::min(lsize, rsize) < numlanes;
+    type_t last[numlanes];
+    if (rsize < lsize) {
+        type_t *lptr = arr + mid;
+        type_t *rptr = buf + rsize;
+        type_t *out = arr + right;
+        std::copy(arr + mid, arr + right, buf);
+        if (blocks) {
+            for (; rptr > buf; --rptr) {
+                type_t *pos
+                        = std::upper_bound(arr + left, lptr, rptr[-1], comp);
+                out = std::move_backward(pos, lptr, out);
+                *--out = rptr[-1];
+                lptr = pos;
+            }
+            return;
+        }
+        merge_vectors_<vtype, comparator, true>(
+                rptr, buf, lptr, arr + left, out, last);
+        // the rest of the right piece and last fill the gap before out
+        std::merge(last, last + numlanes, buf, rptr, lptr, comp);
+        if (lptr > arr + left) {
+            merge_pieces_<vtype, comparator>(
+                    arr, left, lptr - arr, out - arr, buf);
+        }
+    }
+    else {
+        type_t *lptr = buf;
+        type_t *rptr = arr + mid;
+        type_t *out = arr + left;
+        std::copy(arr + left, arr + mid, buf);
+        if (blocks) {
+            for (; lptr < buf + lsize; ++lptr) {
+                type_t *pos = std::lower_bound(rptr, arr + right, *lptr, comp);
+                out = std::move(rptr, pos, out);
+                *out++ = *lptr;
+                rptr = pos;
+            }
+            return;
+        }
+        merge_vectors_<vtype, comparator, false>(
+                lptr, buf + lsize, rptr, arr + right, out, last);
+        // the rest of the left piece and last fill the gap after out
+        std::merge(last, last + numlanes, lptr, buf + lsize, out, comp);
+        if (rptr < arr + right) {
+            merge_pieces_<vtype, comparator>(
+                    arr, out - arr, rptr - arr, right, buf);
+        }
+    }
+}
+
+/* Cheap check whether arr could be made of a few long runs */
+template <typename vtype, typename comparator, typename type_t>
+X86_SIMD_SORT_INLINE bool looks_presorted_(type_t *arr, arrsize_t arrsize)
+{
+    using reverse_comparator = Comparator<vtype, !comparator::is_descending>;
+    if (arrsize < xss_presorted_min_size) return false;
+
+    int unordered_windows = 0;
+    arrsize_t stride = arrsize / xss_presorted_windows;
+    for (int ii = 0; ii < xss_presorted_windows; ++ii) {
+        arrsize_t start = ii * stride;
+        arrsize_t end = start + vtype::numlanes + 1;
+        if (run_end_<vtype, comparator>(arr, start, end) < end
+            && run_end_<vtype, reverse_comparator>(arr, start, end) < end) {
+            unordered_windows++;
+        }
+    }
+    return unordered_windows <= 2;
+}
+
+/*
+ * Sorts arr if it is made of a few long runs. Returns false, leaving arr
+ * untouched, if the caller has to quicksort it instead.
+ */
+template <typename vtype, typename comparator, typename type_t>
+X86_SIMD_SORT_INLINE bool qsort_presorted_(type_t *arr, arrsize_t arrsize)
+{
+    using reverse_comparator = Comparator<vtype, !comparator::is_descending>;
+    if (!looks_presorted_<vtype, comparator>(arr, arrsize)) return false;
+
+    /*
+     * Pieces are [bounds[ii], bounds[ii + 1]); kind[ii] says whether a piece
+     * is a run, a reverse run or unordered
+     */
+    enum class piece_t { run, reverse_run, unordered };
+    arrsize_t bounds[xss_presorted_max_pieces + 1] = {0};
+    piece_t kind[xss_presorted_max_pieces];
+    int num_pieces = 0;
+    arrsize_t min_run = arrsize / xss_presorted_run_div;
+    arrsize_t unordered = 0;
+    arrsize_t pos = 0;
+    while (pos < arrsize) {
+        arrsize_t end = run_end_<vtype, comparator>(arr, pos, arrsize);
+        piece_t this_kind = piece_t::run;
+        if (end - pos < min_run) {
+            arrsize_t rend
+                    = run_end_<vtype, reverse_comparator>(arr, pos, arrsize);
+            this_kind = piece_t::reverse_run;
+            if (rend - pos < min_run) {
+                this_kind = piece_t::unordered;
+                end = skip_unordered_<vtype, comparator>(
+                        arr, std::max(end, rend), arrsize);
+                unordered += end - pos;
+                if (unordered > arrsize / 4) return false;
+            }
+            else {
+                end = rend;
+            }
+        }
+        // consecutive short runs form one unordered piece
+        if (this_kind != piece_t::unordered || num_pieces == 0
+            || kind[num_pieces - 1] != piece_t::unordered) {
+            if (num_pieces == xss_presorted_max_pieces) return false;
+            kind[num_pieces++] = this_kind;
+        }
+        bounds[num_pieces] = end;
+        pos = end;
+    }
+    if (num_pieces == 1 && kind[0] == piece_t::unordered) return false;
+
+    // the largest shorter half of any merge
+    arrsize_t bufsize = 0;
+    for (int width = 1; width < num_pieces; width *= 2) {
+        for (int ii = 0; ii + width < num_pieces; ii += 2 * width) {
+            int last = std::min(ii + 2 * width, num_pieces);
+            bufsize = std::max(bufsize,
+                               std::min(bounds[ii + width] - bounds[ii],
+                                        bounds[last] - bounds[ii + width]));
+        }
+    }
+    std::unique_ptr<type_t[]> buf;
+    if (bufsize > 0) {
+        buf.reset(new (std::nothrow) type_t[bufsize]);
+        if (!buf) return false;
+    }
+
+    for (int ii = 0; ii < num_pieces; ++ii) {
+        arrsize_t size = bounds[ii + 1] - bounds[ii];
+        if (kind[ii] == piece_t::reverse_run) {
+            std::reverse(arr + bounds[ii], arr + bounds[ii + 1]);
+        }
+        else if (kind[ii] == piece_t::unordered && size > 1) {
+            qsort_<vtype, comparator, type_t>(
+                    arr,
+                    bounds[ii],
+                    bounds[ii + 1] - 1,
+                    2 * (arrsize_t)log2(size),
+                    std::numeric_limits<arrsize_t>::max());
+        }
+    }
+    for (int width = 1; width < num_pieces; width *= 2) {
+        for (int ii = 0; ii + width < num_pieces; ii += 2 * width) {
+            int last = std::min(ii + 2 * width, num_pieces);
+            merge_pieces_<vtype, comparator>(arr,
+                                             bounds[ii],
+                                             bounds[ii + width],
+                                             bounds[last],
+                                             buf.get());
+        }
+    }
+    return true;
+}
+
+#endif // XSS_PRESORTED
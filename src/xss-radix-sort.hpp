@@ -0,0 +1,167 @@
+#ifndef XSS_RADIX_SORT
+#define XSS_RADIX_SORT
+
+#include "xss-common-includes.h"
+#include <memory>
+#include <new>
+
+/*
+ * LSD radix sort for large arrays, which quicksort is memory bound on: every
+ * partition level streams the whole array, while the radix sort reads the
+ * keys once to build the histograms of all their 8-bit digits and then
+ * scatters them once per digit between the array and a scratch buffer of the
+ * same size. Digits that are equal in every key (e.g. the top byte of small
+ * integers) need no pass at all.
+ *
+ * Keys are mapped to unsigned integers of the same width that order the same
+ * way: the sign bit is flipped for signed integers, floats go from
+ * sign-magnitude to two's complement order, and all bits are flipped for a
+ * descending sort. Each scatter pass is stable, so values move along with
+ * their keys in the key-value sort. NaNs have to be dealt with by the caller.
+ *
+ * qsort and keyvalue_qsort radix sort arrays of 16-bit and 32-bit keys with
+ * at least XSS_RADIX_SORT_MIN_SIZE elements. That only pays off where
+ * scattered stores run close to memory bandwidth: on the machines we measure
+ * on a scatter pass alone costs more than the whole AVX-512 quicksort, which
+ * stays 2-4x faster from 1M up to 64M elements. The default of 0 therefore
+ * never picks the radix sort. Build with e.g.
+ * -DXSS_RADIX_SORT_MIN_SIZE=16000000 where it wins.
+ */
+#ifndef XSS_RADIX_SORT_MIN_SIZE
+#define XSS_RADIX_SORT_MIN_SIZE 0
+#endif
+
+template <typename T>
+X86_SIMD_SORT_INLINE bool xss_use_radix(arrsize_t arrsize)
+{
+    constexpr arrsize_t min_size = XSS_RADIX_SORT_MIN_SIZE;
+    if constexpr (sizeof(T) == sizeof(uint16_t)
+                  || sizeof(T) == sizeof(uint32_t)) {
+        return min_size > 0 && arrsize >= min_size;
+    }
+    /* 8 passes over 64-bit keys lose to the quicksort at every size */
+    return false;
+}
+
+template <typename T>
+using xss_radix_key_t = typename std::conditional<
+        sizeof(T) == sizeof(uint16_t),
+        uint16_t,
+        typename std::conditional<sizeof(T) == sizeof(uint32_t),
+                                  uint32_t,
+                                  uint64_t>::type>::type;
+
+template <typename T, bool is_float, bool descending>
+X86_SIMD_SORT_FINLINE xss_radix_key_t<T> xss_radix_key(T value)
+{
+    using key_t = xss_radix_key_t<T>;
+    constexpr key_t sign = (key_t)1 << (8 * sizeof(key_t) - 1);
+    key_t bits;
+    std::memcpy(&bits, &value, sizeof(key_t));
+    if constexpr (is_float) {
+        bits = (bits & sign) ? (key_t)~bits : (key_t)(bits | sign);
+    }
+    else if constexpr (std::is_signed_v<T>) {
+        bits ^= sign;
+    }
+    if constexpr (descending) { bits = ~bits; }
+    return bits;
+}
+
+/* Stands in for the values of a radix sort without values */
+struct xss_radix_no_values {};
+
+/*
+ * Sorts keys[0] ... keys[arrsize - 1] and applies the same permutation to
+ * vals unless V is xss_radix_no_values. is_float selects the float key
+ * transform, which is also needed for _Float16 stored as uint16_t. Returns
+ * false, leaving the arrays untouched, if the scratch buffers cannot be
+ * allocated.
+ */
+template <typename T, bool is_float, bool descending, typename V>
+X86_SIMD_SORT_INLINE bool xss_radix_sort(T *keys, V *vals, arrsize_t arrsize)
+{
+    constexpr bool has_vals = !std::is_same_v<V, xss_radix_no_values>;
+    constexpr int num_digits = sizeof(T);
+    using key_t = xss_radix_key_t<T>;
+
+    std::unique_ptr<T[]> keybuf(new (std::nothrow) T[arrsize]);
+    if (!keybuf) return false;
+    std::unique_ptr<V[]> valbuf;
+    if constexpr (has_vals) {
+        valbuf.reset(new (std::nothrow) V[arrsize]);
+        if (!valbuf) return false;
+    }
+
+    arrsize_t counts[num_digits][256] = {};
+    for (arrsize_t ii = 0; ii < arrsize; ++ii) {
+        key_t key = xss_radix_key<T, is_float, descending>(keys[ii]);
+        for (int digit = 0; digit < num_digits; ++digit) {
+            counts[digit][(key >> (8 * digit)) & 0xff]++;
+        }
+    }
+
+    T *src = keys, *dst = keybuf.get();
+    V *srcvals = vals, *dstvals = valbuf.get();
+    const key_t first = xss_radix_key<T, is_float, descending>(keys[0]);
+    for (int digit = 0; digit < num_digits; ++digit) {
+        const int shift = 8 * digit;
+        // the pass would leave every key where it is
+        if (counts[digit][(first >> shift) & 0xff] == arrsize) continue;
+
+        arrsize_t offsets[256];
+        arrsize_t sum = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            offsets[bucket] = sum;
+            sum += counts[digit][bucket];
+        }
+        for (arrsize_t ii = 0; ii < arrsize; ++ii) {
+            key_t key = xss_radix_key<T, is_float, descending>(src[ii]);
+            arrsize_t pos = offsets[(key >> shift) & 0xff]++;
+            dst[pos] = src[ii];
+            if constexpr (has_vals) { dstvals[pos] = srcvals[ii]; }
+        }
+        std::swap(src, dst);
+        if constexpr (has_vals) { std::swap(srcvals, dstvals); }
+    }
+
+    if (src != keys) {
+        std::memcpy(keys, src, arrsize * sizeof(T));
+        if constexpr (has_vals) {
+            std::memcpy(vals, srcvals, arrsize * sizeof(V));
+        }
+    }
+    return true;
+}
+
+/*
+ * Radix sorts arr if that pays off for its type and size. Returns false if
+ * the caller has to quicksort it instead.
+ */
+template <typename T,
+          bool descending,
+          bool is_float = xss::fp::is_floating_point_v<T>>
+X86_SIMD_SORT_INLINE bool xss_radix_qsort(T *arr, arrsize_t arrsize)
+{
+#ifdef XSS_COMPILE_OPENMP
+    // the radix sort is single threaded, the quicksort is not
+    if (xss_get_num_threads() > 1) return false;
+#endif
+    if (!xss_use_radix<T>(arrsize)) return false;
+    return xss_radix_sort<T, is_float, descending>(
+            arr, (xss_radix_no_values *)nullptr, arrsize);
+}
+
+/* Same for the key-value sort, the values move along with their keys */
+template <bool descending, typename T1, typename T2>
+X86_SIMD_SORT_INLINE bool xss_radix_kvsort(T1 *keys, T2 *vals, arrsize_t size)
+{
+#ifdef XSS_COMPILE_OPENMP
+    if (xss_get_num_threads() > 1) return false;
+#endif
+    if (!xss_use_radix<T1>(size)) return false;
+    return xss_radix_sort<T1, xss::fp::is_floating_point_v<T1>, descending>(
+            keys, vals, size);
+}
+
+#endif // XSS_RADIX_SORT
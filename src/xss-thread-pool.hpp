@@ -0,0 +1,209 @@
+#ifndef XSS_THREAD_POOL
+#define XSS_THREAD_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xss {
+
+/*
+ * Work-stealing thread pool used by the *_parallel sorting routines. It does
+ * not depend on OpenMP and can be used with or without it.
+ *
+ * Every worker owns a deque of jobs. A job submitted from a worker thread is
+ * pushed to the back of that worker's deque and the owner pops from the back
+ * (LIFO), which keeps the quicksort recursion depth first. An idle worker
+ * steals from the front of the other deques (FIFO), i.e. it takes the oldest
+ * and hence the largest sub-array that is still waiting. Jobs submitted from
+ * outside the pool are spread over the deques round robin.
+ *
+ * Worker threads are only started on the first call to submit(), so creating
+ * a pool that ends up unused (e.g. to sort a small array) is cheap.
+ */
+class thread_pool {
+public:
+    explicit thread_pool(int num_threads = 0)
+        : nthreads(num_threads > 0 ? num_threads : default_num_threads())
+    {
+        for (int ii = 0; ii < nthreads; ++ii) {
+            queues.emplace_back(new job_queue);
+        }
+    }
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(sleep_lock);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    static int default_num_threads()
+    {
+        unsigned int hw = std::thread::hardware_concurrency();
+        return hw == 0 ? 1 : (int)hw;
+    }
+
+    int num_threads() const
+    {
+        return nthreads;
+    }
+
+    void submit(std::function<void()> job)
+    {
+        std::call_once(started, [this]() {
+            for (int ii = 0; ii < nthreads; ++ii) {
+                workers.emplace_back([this, ii]() { worker_loop(ii); });
+            }
+        });
+
+        size_t id;
+        if (current.pool == this) { id = current.index; }
+        else {
+            id = next_queue.fetch_add(1, std::memory_order_relaxed)
+                    % queues.size();
+        }
+        /* Count the job before it becomes visible so that the counter never
+         * drops below the number of jobs sitting in the deques */
+        num_queued.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lk(queues[id]->lock);
+            queues[id]->jobs.push_back(std::move(job));
+        }
+        {
+            std::lock_guard<std::mutex> lk(sleep_lock);
+        }
+        wakeup.notify_one();
+    }
+
+private:
+    struct job_queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    struct worker_id {
+        thread_pool *pool;
+        size_t index;
+    };
+
+    bool pop_local(size_t id, std::function<void()> &job)
+    {
+        std::lock_guard<std::mutex> lk(queues[id]->lock);
+        if (queues[id]->jobs.empty()) return false;
+        job = std::move(queues[id]->jobs.back());
+        queues[id]->jobs.pop_back();
+        return true;
+    }
+
+    bool steal(size_t id, std::function<void()> &job)
+    {
+        for (size_t ii = 1; ii < queues.size(); ++ii) {
+            job_queue &victim = *queues[(id + ii) % queues.size()];
+            std::lock_guard<std::mutex> lk(victim.lock);
+            if (victim.jobs.empty()) continue;
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void worker_loop(size_t id)
+    {
+        current = {this, id};
+        std::function<void()> job;
+        while (true) {
+            if (pop_local(id, job) || steal(id, job)) {
+                num_queued.fetch_sub(1);
+                job();
+                job = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(sleep_lock);
+            wakeup.wait(lk, [this]() { return stopping || num_queued > 0; });
+            if (stopping) return;
+        }
+    }
+
+    inline static thread_local worker_id current = {nullptr, 0};
+
+    const int nthreads;
+    std::vector<std::unique_ptr<job_queue>> queues;
+    std::vector<std::thread> workers;
+    std::once_flag started;
+    std::atomic<size_t> next_queue = 0;
+    std::atomic<size_t> num_queued = 0;
+    std::mutex sleep_lock;
+    std::condition_variable wakeup;
+    bool stopping = false;
+};
+
+/*
+ * Tracks the jobs that one parallel sort submits to an executor, which is any
+ * object with a submit(std::function<void()>) method (e.g. xss::thread_pool).
+ * Jobs never wait on each other: only the thread that owns the task_group
+ * blocks in wait(), so any executor that eventually runs every submitted job
+ * is safe to use, even one that runs them inline.
+ */
+template <typename executor_t>
+class task_group {
+public:
+    explicit task_group(executor_t &ex) : ex(ex) {}
+
+    ~task_group()
+    {
+        wait();
+    }
+
+    task_group(const task_group &) = delete;
+    task_group &operator=(const task_group &) = delete;
+
+    template <typename Func>
+    void run(Func func)
+    {
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            ++pending;
+        }
+        ex.submit([this, func]() {
+            func();
+            finish();
+        });
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lk(lock);
+        done.wait(lk, [this]() { return pending == 0; });
+    }
+
+private:
+    void finish()
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        if (--pending == 0) { done.notify_all(); }
+    }
+
+    executor_t &ex;
+    std::mutex lock;
+    std::condition_variable done;
+    size_t pending = 0;
+};
+
+} // namespace xss
+
+#endif // XSS_THREAD_POOL
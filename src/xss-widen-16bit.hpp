@@ -0,0 +1,85 @@
+#ifndef XSS_WIDEN_16BIT
+#define XSS_WIDEN_16BIT
+
+#include <memory>
+
+/*
+ * Routines that do not have 16-bit kernels (argsort, key-value sort) work on a
+ * copy of the 16-bit data widened to 32 bits: int16_t and uint16_t are sign or
+ * zero extended and _Float16 and __bf16 convert to float exactly, so the order
+ * (including NaNs) is unchanged and the 32-bit kernels can be used as is.
+ */
+template <typename T>
+using xss_widened_t = typename std::conditional<
+        std::is_integral_v<T>,
+        typename std::conditional<std::is_signed_v<T>, int32_t, uint32_t>::type,
+        float>::type;
+
+template <typename T>
+X86_SIMD_SORT_INLINE std::unique_ptr<xss_widened_t<T>[]>
+xss_widen_16bit(T *arr, arrsize_t arrsize)
+{
+    std::unique_ptr<xss_widened_t<T>[]> wide(new xss_widened_t<T>[arrsize]);
+    arrsize_t ii = 0;
+    if constexpr (std::is_integral_v<T>) {
+        for (; ii < arrsize; ++ii) {
+            wide[ii] = arr[ii];
+        }
+    }
+#ifdef __BFLT16_MAX__
+    else if constexpr (std::is_same_v<T, __bf16>) {
+        /* a bfloat16 is the upper half of the float it widens to */
+        const uint16_t *bits = (const uint16_t *)arr;
+        uint32_t *wide_bits = (uint32_t *)wide.get();
+#ifdef __AVX2__
+        for (; ii + 8 <= arrsize; ii += 8) {
+            __m128i h = _mm_loadu_si128((__m128i const *)(bits + ii));
+            __m256i w = _mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16);
+            _mm256_storeu_si256((__m256i *)(wide_bits + ii), w);
+        }
+#endif
+        for (; ii < arrsize; ++ii) {
+            wide_bits[ii] = (uint32_t)bits[ii] << 16;
+        }
+    }
+#endif
+    else {
+#ifdef __F16C__
+        for (; ii + 8 <= arrsize; ii += 8) {
+            __m128i h = _mm_loadu_si128((__m128i const *)(arr + ii));
+            _mm256_storeu_ps(wide.get() + ii, _mm256_cvtph_ps(h));
+        }
+#endif
+        for (; ii < arrsize; ++ii) {
+            wide[ii] = (float)arr[ii];
+        }
+    }
+    return wide;
+}
+
+/* Inverse of xss_widen_16bit, exact for every value that came out of it */
+template <typename T>
+X86_SIMD_SORT_INLINE void
+xss_narrow_16bit(xss_widened_t<T> *wide, T *arr, arrsize_t arrsize)
+{
+    arrsize_t ii = 0;
+    if constexpr (std::is_integral_v<T>) {
+        for (; ii < arrsize; ++ii) {
+            arr[ii] = (T)wide[ii];
+        }
+    }
+    else {
+#ifdef __F16C__
+        for (; ii + 8 <= arrsize; ii += 8) {
+            __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(wide + ii),
+                                        _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128((__m128i *)(arr + ii), h);
+        }
+#endif
+        for (; ii < arrsize; ++ii) {
+            arr[ii] = (T)wide[ii];
+        }
+    }
+}
+
+#endif // XSS_WIDEN_16BIT
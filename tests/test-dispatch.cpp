@@ -0,0 +1,188 @@
+/*******************************************
+ * * Copyright (C) 2022-2023 Intel Corporation
+ * * SPDX-License-Identifier: BSD-3-Clause
+ * *******************************************/
+
+#include "rand_array.h"
+#include "x86simdsort.h"
+#include <gtest/gtest.h>
+#include <set>
+
+static std::string
+find_isa(const std::vector<x86simdsort::dispatch_entry> &table,
+         const std::string &routine,
+         const std::string &type)
+{
+    for (auto &entry : table) {
+        if (entry.routine == routine && entry.type == type) {
+            return entry.isa;
+        }
+    }
+    return "";
+}
+
+TEST(dispatch, table_is_complete)
+{
+    auto table = x86simdsort::get_dispatch_table();
+    std::set<std::string> valid_isa
+            = {"avx512_zen4",
+               "avx512_spr",
+               "avx512_icl",
+               "avx512_skx",
+               "avx10_256",
+               "avx2",
+               "scalar"};
+    std::set<std::pair<std::string, std::string>> seen;
+    for (auto &entry : table) {
+        EXPECT_TRUE(valid_isa.count(entry.isa)) << entry.isa;
+        EXPECT_TRUE(seen.insert({entry.routine, entry.type}).second)
+                << entry.routine << " " << entry.type;
+    }
+    for (std::string type : {"uint16_t",
+                             "int16_t",
+                             "float",
+                             "int32_t",
+                             "uint32_t",
+                             "int64_t",
+                             "uint64_t",
+                             "double"}) {
+        for (std::string routine : {"qsort", "qselect", "partial_qsort"}) {
+            EXPECT_NE(find_isa(table, routine, type), "")
+                    << routine << " " << type;
+        }
+    }
+    EXPECT_NE(find_isa(table, "keyvalue_qsort", "uint64_t,double"), "");
+}
+
+TEST(dispatch, table_matches_cpu)
+{
+    if (std::getenv("XSS_PREFERRED_ISA")) {
+        GTEST_SKIP() << "dispatch is capped by XSS_PREFERRED_ISA";
+    }
+    auto table = x86simdsort::get_dispatch_table();
+    __builtin_cpu_init();
+    bool avx512 = __builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512dq")
+            && __builtin_cpu_supports("avx512vl")
+            && std::getenv("XSS_DISABLE_AVX512") == nullptr;
+    std::string expected = avx512 ? "avx512_skx"
+            : __builtin_cpu_supports("avx2") ? "avx2"
+                                              : "scalar";
+    /* AMD CPUs with AVX-512 get the register compress quicksort kernels */
+    bool zen4 = avx512 && __builtin_cpu_supports("avx512bw")
+            && __builtin_cpu_supports("avx512vbmi2")
+            && __builtin_cpu_is("amd");
+    EXPECT_EQ(find_isa(table, "qsort", "float"),
+              zen4 ? "avx512_zen4" : expected);
+    EXPECT_EQ(find_isa(table, "argsort", "double"), expected);
+    EXPECT_EQ(find_isa(table, "keyvalue_qsort", "float,uint32_t"), expected);
+}
+
+TEST(dispatch, table_is_stable)
+{
+    /* the table does not change once it has been used */
+    std::vector<double> arr = {3.0, 1.0, 2.0};
+    x86simdsort::qsort(arr.data(), arr.size());
+    EXPECT_EQ(arr, std::vector<double>({1.0, 2.0, 3.0}));
+    auto before = x86simdsort::get_dispatch_table();
+    auto after = x86simdsort::get_dispatch_table();
+    ASSERT_EQ(before.size(), after.size());
+    for (size_t ii = 0; ii < before.size(); ++ii) {
+        EXPECT_EQ(before[ii].isa, after[ii].isa);
+    }
+}
+
+TEST(dispatch, set_preferred_isa)
+{
+    ASSERT_TRUE(x86simdsort::set_preferred_isa(""));
+    std::string native = x86simdsort::get_dispatched_isa<float>("qsort");
+    EXPECT_FALSE(x86simdsort::set_preferred_isa("avx1024"));
+    EXPECT_EQ(x86simdsort::get_dispatched_isa<float>("qsort"), native);
+
+    ASSERT_TRUE(x86simdsort::set_preferred_isa("scalar"));
+    for (auto &entry : x86simdsort::get_dispatch_table()) {
+        EXPECT_EQ(entry.isa, "scalar") << entry.routine << " " << entry.type;
+    }
+    std::vector<float> arr = {3.0f, 1.0f, 2.0f};
+    x86simdsort::qsort(arr.data(), arr.size());
+    EXPECT_EQ(arr, std::vector<float>({1.0f, 2.0f, 3.0f}));
+
+    ASSERT_TRUE(x86simdsort::set_preferred_isa("avx2"));
+    std::string expected = native == "scalar" ? "scalar" : "avx2";
+    EXPECT_EQ(x86simdsort::get_dispatched_isa<float>("qsort"), expected);
+    std::string kv_isa = x86simdsort::get_dispatched_isa<uint64_t, double>(
+            "keyvalue_qsort");
+    EXPECT_EQ(kv_isa, expected);
+    x86simdsort::qsort(arr.data(), arr.size(), false, true);
+    EXPECT_EQ(arr, std::vector<float>({3.0f, 2.0f, 1.0f}));
+
+    ASSERT_TRUE(x86simdsort::set_preferred_isa(""));
+    EXPECT_EQ(x86simdsort::get_dispatched_isa<float>("qsort"), native);
+    EXPECT_EQ(x86simdsort::get_dispatched_isa<float>("no_such_routine"), "");
+
+    /* restore the cap the other tests run with */
+    const char *env_isa = std::getenv("XSS_PREFERRED_ISA");
+    x86simdsort::set_preferred_isa(env_isa ? env_isa : "");
+}
+
+template <typename T>
+static void check_qsort(size_t size, bool descending)
+{
+    std::vector<T> arr = get_array<T>("random", size);
+    std::vector<T> sorted = arr;
+    if (descending) { std::sort(sorted.rbegin(), sorted.rend()); }
+    else {
+        std::sort(sorted.begin(), sorted.end());
+    }
+    x86simdsort::qsort(arr.data(), arr.size(), false, descending);
+    EXPECT_EQ(arr, sorted) << size << " " << descending;
+}
+
+TEST(dispatch, avx10_256_kernels)
+{
+    ASSERT_TRUE(x86simdsort::set_preferred_isa("avx10_256"));
+    if (x86simdsort::get_dispatched_isa<float>("qsort") != "avx10_256") {
+        x86simdsort::set_preferred_isa("");
+        GTEST_SKIP() << "CPU lacks AVX10/256";
+    }
+    /* 16-bit types and argsort keep their own kernels */
+    EXPECT_NE(x86simdsort::get_dispatched_isa<uint16_t>("qsort"), "avx10_256");
+    EXPECT_NE(x86simdsort::get_dispatched_isa<float>("argsort"), "avx10_256");
+    for (size_t size : {3, 17, 300, 10000}) {
+        for (bool descending : {false, true}) {
+            check_qsort<float>(size, descending);
+            check_qsort<int32_t>(size, descending);
+            check_qsort<uint32_t>(size, descending);
+            check_qsort<double>(size, descending);
+            check_qsort<int64_t>(size, descending);
+            check_qsort<uint64_t>(size, descending);
+        }
+    }
+    const char *env_isa = std::getenv("XSS_PREFERRED_ISA");
+    x86simdsort::set_preferred_isa(env_isa ? env_isa : "");
+}
+
+TEST(dispatch, avx2_16bit_kernels)
+{
+    ASSERT_TRUE(x86simdsort::set_preferred_isa("avx2"));
+    if (x86simdsort::get_dispatched_isa<float>("qsort") != "avx2") {
+        x86simdsort::set_preferred_isa("");
+        GTEST_SKIP() << "CPU lacks AVX2";
+    }
+    EXPECT_EQ(x86simdsort::get_dispatched_isa<uint16_t>("qsort"), "avx2");
+    EXPECT_EQ(x86simdsort::get_dispatched_isa<int16_t>("qselect"), "avx2");
+#ifdef __FLT16_MAX__
+    EXPECT_EQ(x86simdsort::get_dispatched_isa<_Float16>("qsort"), "avx2");
+#endif
+    for (size_t size : {3, 17, 300, 10000}) {
+        for (bool descending : {false, true}) {
+            check_qsort<int16_t>(size, descending);
+            check_qsort<uint16_t>(size, descending);
+#ifdef __FLT16_MAX__
+            check_qsort<_Float16>(size, descending);
+#endif
+        }
+    }
+    const char *env_isa = std::getenv("XSS_PREFERRED_ISA");
+    x86simdsort::set_preferred_isa(env_isa ? env_isa : "");
+}
@@ -236,6 +236,52 @@ TYPED_TEST_P(simdkvsort, test_kvsort_descending)
     }
 }
 
+TYPED_TEST_P(simdkvsort, test_kvsort_stable)
+{
+    using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
+    using T2 = typename std::tuple_element<1, decltype(TypeParam())>::type;
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : this->arrsize) {
+            std::vector<T1> key = get_array<T1>(type, size);
+            for (bool descending : {false, true}) {
+                // values record the input position of every key
+                std::vector<T2> val(size);
+                std::iota(val.begin(), val.end(), 0);
+                std::vector<size_t> arg(size);
+                std::iota(arg.begin(), arg.end(), 0);
+                if (descending) {
+                    std::stable_sort(arg.begin(),
+                                     arg.end(),
+                                     compare_arg<T1, std::greater<T1>>(
+                                             key.data()));
+                }
+                else {
+                    std::stable_sort(arg.begin(),
+                                     arg.end(),
+                                     compare_arg<T1, std::less<T1>>(
+                                             key.data()));
+                }
+                std::vector<T1> key_sorted = key;
+                x86simdsort::keyvalue_stable_sort(key_sorted.data(),
+                                                  val.data(),
+                                                  size,
+                                                  hasnan,
+                                                  descending);
+                for (size_t ii = 0; ii < size; ++ii) {
+                    ASSERT_EQ(val[ii], (T2)arg[ii])
+                            << "type = " << type << ", size = " << size
+                            << ", descending = " << descending;
+                    ASSERT_EQ(memcmp(&key_sorted[ii],
+                                     &key[arg[ii]],
+                                     sizeof(T1)),
+                              0);
+                }
+            }
+        }
+    }
+}
+
 TYPED_TEST_P(simdkvsort, test_kvselect_ascending)
 {
     using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
@@ -408,13 +454,121 @@ TYPED_TEST_P(simdkvsort, test_kvpartial_sort_descending)
     }
 }
 
+TYPED_TEST_P(simdkvsort, test_kvpartial_sort_topk)
+{
+    // k much smaller than the array takes the top-k filter
+    using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
+    using T2 = typename std::tuple_element<1, decltype(TypeParam())>::type;
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (size_t size : {4096, 20000}) {
+            std::vector<T1> basekey = get_array<T1>(type, size);
+            std::vector<T2> baseval = get_array<T2>(type, size);
+            for (size_t k : {1, 50}) {
+                for (bool descending : {false, true}) {
+                    std::vector<T1> key = basekey;
+                    std::vector<T2> val = baseval;
+                    std::vector<T1> key_bckp = basekey;
+                    std::vector<T2> val_bckp = baseval;
+
+                    x86simdsort::keyvalue_partial_sort(key.data(),
+                                                       val.data(),
+                                                       k,
+                                                       size,
+                                                       hasnan,
+                                                       descending);
+#ifndef XSS_ASAN_CI_NOCHECK
+                    xss::scalar::keyvalue_qsort(key_bckp.data(),
+                                                val_bckp.data(),
+                                                size,
+                                                hasnan,
+                                                descending);
+
+                    IS_ARR_PARTIALSORTED<T1>(key, k, key_bckp, type);
+
+                    bool is_kv_partialsorted_
+                            = is_kv_partialsorted<T1, T2>(key.data(),
+                                                          val.data(),
+                                                          key_bckp.data(),
+                                                          val_bckp.data(),
+                                                          size,
+                                                          k);
+                    ASSERT_EQ(is_kv_partialsorted_, true);
+#endif
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdkvsort, test_kvtopk_accumulator)
+{
+    using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
+    using T2 = typename std::tuple_element<1, decltype(TypeParam())>::type;
+    for (auto type : this->arrtype) {
+        for (size_t size : {0, 10, 1000, 20000}) {
+            std::vector<T1> key = get_array<T1>(type, size);
+            // Each value is the position of its key in the input
+            std::vector<T2> val(size);
+            for (size_t ii = 0; ii < size; ++ii) {
+                val[ii] = (T2)ii;
+            }
+            // NaNs never make it into the top k
+            std::vector<T1> sortedkey;
+            for (auto x : key) {
+                if (x == x) { sortedkey.push_back(x); }
+            }
+            for (size_t k : {1, 10, 100}) {
+                for (bool descending : {false, true}) {
+                    x86simdsort::keyvalue_topk_accumulator<T1, T2> acc(
+                            k, descending);
+                    // Push chunks of growing size, 1, 3, 7, ...
+                    size_t pos = 0;
+                    for (size_t len = 1; pos < size; len = 2 * len + 1) {
+                        size_t n = std::min(len, size - pos);
+                        acc.push(key.data() + pos, val.data() + pos, n);
+                        pos += n;
+                    }
+                    auto [topk, topv] = acc.finalize();
+#ifndef XSS_ASAN_CI_NOCHECK
+                    if (descending) {
+                        std::sort(sortedkey.begin(),
+                                  sortedkey.end(),
+                                  std::greater<T1>());
+                    }
+                    else {
+                        std::sort(sortedkey.begin(), sortedkey.end());
+                    }
+                    ASSERT_EQ(topk.size(), std::min(k, sortedkey.size()));
+                    ASSERT_EQ(topv.size(), topk.size());
+                    IS_ARR_PARTIALSORTED<T1>(
+                            topk, topk.size(), sortedkey, type);
+                    std::vector<size_t> seen;
+                    for (size_t ii = 0; ii < topk.size(); ++ii) {
+                        size_t jj = (size_t)topv[ii];
+                        ASSERT_EQ(key[jj], topk[ii]);
+                        seen.push_back(jj);
+                    }
+                    std::sort(seen.begin(), seen.end());
+                    ASSERT_TRUE(std::adjacent_find(seen.begin(), seen.end())
+                                == seen.end());
+#endif
+                }
+            }
+        }
+    }
+}
+
 REGISTER_TYPED_TEST_SUITE_P(simdkvsort,
                             test_kvsort_ascending,
                             test_kvsort_descending,
+                            test_kvsort_stable,
                             test_kvselect_ascending,
                             test_kvselect_descending,
                             test_kvpartial_sort_ascending,
-                            test_kvpartial_sort_descending);
+                            test_kvpartial_sort_descending,
+                            test_kvpartial_sort_topk,
+                            test_kvtopk_accumulator);
 
 #define CREATE_TUPLES(type) \
     std::tuple<double, type>, std::tuple<uint64_t, type>, \
@@ -429,3 +583,19 @@ using QKVSortTestTypes = testing::Types<CREATE_TUPLES(double),
                                         CREATE_TUPLES(float)>;
 
 INSTANTIATE_TYPED_TEST_SUITE_P(xss, simdkvsort, QKVSortTestTypes);
+
+#define CREATE_TUPLES_16BIT(type) \
+    std::tuple<uint16_t, type>, std::tuple<int16_t, type>
+
+using QKVSort16bitTestTypes = testing::Types<CREATE_TUPLES_16BIT(double),
+                                             CREATE_TUPLES_16BIT(uint64_t),
+                                             CREATE_TUPLES_16BIT(uint32_t),
+                                             CREATE_TUPLES_16BIT(float),
+                                             CREATE_TUPLES_16BIT(uint16_t),
+                                             CREATE_TUPLES_16BIT(int16_t),
+                                             std::tuple<double, uint16_t>,
+                                             std::tuple<int64_t, int16_t>,
+                                             std::tuple<float, uint16_t>,
+                                             std::tuple<int32_t, int16_t>>;
+
+INSTANTIATE_TYPED_TEST_SUITE_P(xss_16bit, simdkvsort, QKVSort16bitTestTypes);
@@ -72,7 +72,144 @@ TYPED_TEST_P(simdobjsort, test_objsort)
     }
 }
 
-REGISTER_TYPED_TEST_SUITE_P(simdobjsort, test_objsort);
+TYPED_TEST_P(simdobjsort, test_objsort_nontrivial)
+{
+    // Objects that are not trivially copyable are permuted in place
+    struct Q {
+        TypeParam x;
+        std::string name;
+        bool operator==(const Q &a) const
+        {
+            return a.x == x && a.name == name;
+        }
+    };
+    for (auto type : this->arrtype) {
+        for (auto size : {0, 1, 10, 100, 1000}) {
+            std::vector<TypeParam> x = get_array<TypeParam>(type, size);
+            std::vector<Q> arr(size);
+            for (int ii = 0; ii < size; ++ii) {
+                arr[ii].x = x[ii];
+                arr[ii].name = std::to_string(x[ii]);
+            }
+            std::vector<Q> arr_bckp = arr;
+
+            x86simdsort::object_qsort(
+                    arr.data(), size, [](const Q &q) { return q.x; });
+            std::sort(arr_bckp.begin(),
+                      arr_bckp.end(),
+                      [](const Q &a, const Q &b) { return a.x < b.x; });
+            ASSERT_EQ(arr, arr_bckp);
+        }
+    }
+}
+
+TYPED_TEST_P(simdobjsort, test_objsort_two_keys)
+{
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> x = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> y = get_array<TypeParam>("smallrange", size);
+            std::vector<P<TypeParam>> arr(size);
+            for (size_t ii = 0; ii < size; ++ii) {
+                arr[ii].x = x[ii];
+                arr[ii].y = y[ii];
+            }
+            std::vector<P<TypeParam>> arr_bckp = arr;
+
+            x86simdsort::object_qsort(
+                    arr.data(),
+                    size,
+                    std::make_tuple([](P<TypeParam> p) { return p.x; },
+                                    [](P<TypeParam> p) { return p.y; }));
+            std::sort(arr_bckp.begin(),
+                      arr_bckp.end(),
+                      [](const P<TypeParam> &a, const P<TypeParam> &b) {
+                          return std::tie(a.x, a.y) < std::tie(b.x, b.y);
+                      });
+            for (size_t ii = 0; ii < size; ++ii) {
+                ASSERT_EQ(arr[ii].x, arr_bckp[ii].x);
+                ASSERT_EQ(arr[ii].y, arr_bckp[ii].y);
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdobjsort, test_objsort_stable)
+{
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> x = get_array<TypeParam>(type, size);
+            std::vector<P<TypeParam>> arr(size);
+            for (size_t ii = 0; ii < size; ++ii) {
+                arr[ii].x = x[ii];
+                arr[ii].y = (TypeParam)ii;
+            }
+            std::vector<P<TypeParam>> arr_bckp = arr;
+
+            x86simdsort::object_stable_sort(
+                    arr.data(), size, [](P<TypeParam> p) { return p.x; });
+            std::stable_sort(arr_bckp.begin(),
+                             arr_bckp.end(),
+                             [](const P<TypeParam> &a, const P<TypeParam> &b) {
+                                 return a.x < b.x;
+                             });
+            for (size_t ii = 0; ii < size; ++ii) {
+                ASSERT_EQ(arr[ii].x, arr_bckp[ii].x);
+                ASSERT_EQ(arr[ii].y, arr_bckp[ii].y);
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdobjsort, test_objsort_by_member)
+{
+    // The members are loaded with strided_gather, and the batched key functor
+    // fills all the keys in one call
+    struct R {
+        TypeParam x;
+        char tag;
+        TypeParam y;
+    };
+    struct batched_key {
+        TypeParam operator()(const R &r) const
+        {
+            return r.y;
+        }
+        void operator()(const R *objs, size_t n, TypeParam *keys) const
+        {
+            for (size_t ii = 0; ii < n; ++ii) {
+                keys[ii] = objs[ii].y;
+            }
+        }
+    };
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> x = get_array<TypeParam>("random", size);
+            std::vector<TypeParam> y = get_array<TypeParam>(type, size);
+            std::vector<R> arr(size);
+            for (size_t ii = 0; ii < size; ++ii) {
+                arr[ii] = {x[ii], (char)ii, y[ii]};
+            }
+            std::vector<R> by_member = arr;
+            std::vector<R> batched = arr;
+
+            x86simdsort::object_qsort_by_member<&R::y>(by_member.data(), size);
+            x86simdsort::object_qsort(batched.data(), size, batched_key());
+            std::sort(y.begin(), y.end());
+            for (size_t ii = 0; ii < size; ++ii) {
+                ASSERT_EQ(by_member[ii].y, y[ii]);
+                ASSERT_EQ(batched[ii].y, y[ii]);
+            }
+        }
+    }
+}
+
+REGISTER_TYPED_TEST_SUITE_P(simdobjsort,
+                            test_objsort,
+                            test_objsort_nontrivial,
+                            test_objsort_two_keys,
+                            test_objsort_stable,
+                            test_objsort_by_member);
 
 using QObjSortTestTypes
         = testing::Types<double, uint64_t, int64_t, uint32_t, int32_t, float>;
@@ -7,6 +7,8 @@
 #include "rand_array.h"
 #include "x86simdsort.h"
 #include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
 
 #define EXPECT_UNIQUE(arg) \
     auto sorted_arg = arg; \
@@ -20,6 +22,26 @@
     ASSERT_TRUE(false) << msg << ". arr size = " << size \
                        << ", type = " << type << ", k = " << k;
 
+/* Executor for the parallel tests that starts a new thread for every job */
+class thread_per_job_executor : public x86simdsort::executor {
+public:
+    void submit(std::function<void()> job) override
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        threads.emplace_back(std::move(job));
+    }
+    ~thread_per_job_executor()
+    {
+        for (auto &t : threads) {
+            t.join();
+        }
+    }
+
+private:
+    std::mutex lock;
+    std::vector<std::thread> threads;
+};
+
 inline bool is_nan_test(std::string type)
 {
     // Currently, determine whether the test uses nan just be checking if nan is in its name
@@ -85,6 +85,236 @@ TYPED_TEST_P(simdsort, test_qsort_descending)
     }
 }
 
+TYPED_TEST_P(simdsort, test_qsort_narrow_range)
+{
+    /* integer arrays like these are counting sorted */
+    if constexpr (std::is_integral_v<TypeParam>) {
+        using T = TypeParam;
+        const T lowest = std::numeric_limits<T>::min();
+        const T highest = std::numeric_limits<T>::max();
+        for (T span : {(T)100, (T)1000, (T)30000}) {
+            T middle = std::is_signed_v<T> ? (T)(-span / 2) : span;
+            for (T min : {lowest, (T)(highest - span), middle}) {
+                for (size_t size : {600, 5000, 300'000}) {
+                    std::vector<T> basearr = get_array<T>(
+                            "random", size, min, (T)(min + span));
+                    std::vector<T> arr = basearr;
+                    std::vector<T> sortedarr = basearr;
+                    std::sort(sortedarr.begin(), sortedarr.end());
+                    x86simdsort::qsort(arr.data(), arr.size());
+                    IS_SORTED(sortedarr, arr, "narrow_range");
+
+                    arr = basearr;
+                    std::reverse(sortedarr.begin(), sortedarr.end());
+                    x86simdsort::qsort(arr.data(), arr.size(), false, true);
+                    IS_SORTED(sortedarr, arr, "narrow_range");
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_qsort_presorted)
+{
+    /* arrays made of a few long runs are merged instead of quicksorted */
+    using T = TypeParam;
+    std::vector<std::string> layouts = {"sorted",
+                                        "reverse",
+                                        "tail1%",
+                                        "tail10%",
+                                        "4runs",
+                                        "ascdesc",
+                                        "swaps",
+                                        "64runs"};
+    auto ascending = compare<T, std::less<T>>();
+    auto descending = compare<T, std::greater<T>>();
+    for (auto layout : layouts) {
+        for (size_t size : {1024, 1500, 10'000, 300'000}) {
+            for (auto type : {"random", "smallrange"}) {
+                std::vector<T> basearr = get_array<T>(type, size);
+                auto begin = basearr.begin(), end = basearr.end();
+                if (layout == "sorted") {
+                    std::sort(begin, end, ascending);
+                }
+                else if (layout == "reverse") {
+                    std::sort(begin, end, descending);
+                }
+                else if (layout == "tail1%") {
+                    std::sort(begin, end - size / 100, ascending);
+                }
+                else if (layout == "tail10%") {
+                    std::sort(begin, end - size / 10, descending);
+                }
+                else if (layout == "ascdesc") {
+                    std::sort(begin, begin + size / 3, ascending);
+                    std::sort(begin + size / 3, end, descending);
+                }
+                else if (layout == "swaps") {
+                    std::sort(begin, end, ascending);
+                    for (size_t ii = 1; ii < size; ii += size / 3) {
+                        std::swap(basearr[ii], basearr[size - ii]);
+                    }
+                }
+                else {
+                    size_t runs = layout == "4runs" ? 4 : 64;
+                    for (size_t ii = 0; ii < runs; ++ii) {
+                        auto run_begin = begin + ii * size / runs;
+                        auto run_end = begin + (ii + 1) * size / runs;
+                        if (ii % 3) {
+                            std::sort(run_begin, run_end, ascending);
+                        }
+                        else {
+                            std::sort(run_begin, run_end, descending);
+                        }
+                    }
+                }
+
+                std::vector<T> arr = basearr;
+                std::vector<T> sortedarr = basearr;
+                std::sort(sortedarr.begin(), sortedarr.end(), ascending);
+                x86simdsort::qsort(arr.data(), arr.size());
+                IS_SORTED(sortedarr, arr, layout);
+
+                arr = basearr;
+                std::reverse(sortedarr.begin(), sortedarr.end());
+                x86simdsort::qsort(arr.data(), arr.size(), false, true);
+                IS_SORTED(sortedarr, arr, layout);
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_qsort_many_nans)
+{
+    /* NaNs are found in the first partition of arrays like these */
+    using T = TypeParam;
+    if constexpr (xss::fp::is_floating_point_v<T>) {
+        auto ascending = compare<T, std::less<T>>();
+        auto descending = compare<T, std::greater<T>>();
+        for (size_t size : {2'000, 300'000}) {
+            // every nan_stride-th element is a NaN
+            for (size_t nan_stride : {100, 2, 1}) {
+                std::vector<T> basearr = get_array<T>("random", size);
+                for (size_t ii = 0; ii < size; ii += nan_stride) {
+                    basearr[ii] = xss::fp::quiet_NaN<T>();
+                }
+                std::string type = "nan_stride_" + std::to_string(nan_stride);
+
+                std::vector<T> arr = basearr;
+                std::vector<T> sortedarr = basearr;
+                std::sort(sortedarr.begin(), sortedarr.end(), ascending);
+                x86simdsort::qsort(arr.data(), arr.size(), true);
+                IS_SORTED(sortedarr, arr, type);
+
+                arr = basearr;
+                std::sort(sortedarr.begin(), sortedarr.end(), descending);
+                x86simdsort::qsort(arr.data(), arr.size(), true, true);
+                IS_SORTED(sortedarr, arr, type);
+
+                for (size_t k : {(size_t)0, size / 2, size - 1}) {
+                    arr = basearr;
+                    sortedarr = basearr;
+                    x86simdsort::qselect(arr.data(), k, arr.size(), true);
+                    std::nth_element(sortedarr.begin(),
+                                     sortedarr.begin() + k,
+                                     sortedarr.end(),
+                                     ascending);
+                    IS_ARR_PARTITIONED(arr, k, sortedarr[k], type);
+
+                    arr = basearr;
+                    sortedarr = basearr;
+                    x86simdsort::qselect(arr.data(), k, arr.size(), true, true);
+                    std::nth_element(sortedarr.begin(),
+                                     sortedarr.begin() + k,
+                                     sortedarr.end(),
+                                     descending);
+                    IS_ARR_PARTITIONED(arr, k, sortedarr[k], type, true);
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_qsort_parallel)
+{
+    std::vector<size_t> sizes = {0, 1, 100, 1000, 100'001, 500'000};
+    thread_per_job_executor ex;
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : sizes) {
+            std::vector<TypeParam> basearr = get_array<TypeParam>(type, size);
+            for (bool descending : {false, true}) {
+                std::vector<TypeParam> arr = basearr;
+                std::vector<TypeParam> sortedarr = arr;
+                if (descending) {
+                    std::sort(sortedarr.begin(),
+                              sortedarr.end(),
+                              compare<TypeParam, std::greater<TypeParam>>());
+                }
+                else {
+                    std::sort(sortedarr.begin(),
+                              sortedarr.end(),
+                              compare<TypeParam, std::less<TypeParam>>());
+                }
+
+                // Library owned thread pool
+                x86simdsort::qsort_parallel(
+                        arr.data(), arr.size(), 4, hasnan, descending);
+                IS_SORTED(sortedarr, arr, type);
+
+                // Caller provided executor
+                arr = basearr;
+                x86simdsort::qsort_parallel(
+                        arr.data(), arr.size(), ex, hasnan, descending);
+                IS_SORTED(sortedarr, arr, type);
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_qsort_segments)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        std::vector<TypeParam> basearr;
+        std::vector<size_t> offsets = {0};
+        for (size_t size = 0; size < 1024; size += 1 + size / 8) {
+            std::vector<TypeParam> seg = get_array<TypeParam>(type, size);
+            basearr.insert(basearr.end(), seg.begin(), seg.end());
+            offsets.push_back(basearr.size());
+        }
+        size_t num_segments = offsets.size() - 1;
+
+        for (bool descending : {false, true}) {
+            std::vector<TypeParam> arr = basearr;
+            std::vector<TypeParam> sortedarr = basearr;
+
+            x86simdsort::qsort_segments(arr.data(),
+                                        offsets.data(),
+                                        num_segments,
+                                        hasnan,
+                                        descending);
+#ifndef XSS_ASAN_CI_NOCHECK
+            for (size_t ii = 0; ii < num_segments; ++ii) {
+                auto first = sortedarr.begin() + offsets[ii];
+                auto last = sortedarr.begin() + offsets[ii + 1];
+                if (descending) {
+                    std::sort(first,
+                              last,
+                              compare<TypeParam, std::greater<TypeParam>>());
+                }
+                else {
+                    std::sort(first,
+                              last,
+                              compare<TypeParam, std::less<TypeParam>>());
+                }
+            }
+            IS_SORTED(sortedarr, arr, type);
+#endif
+        }
+    }
+}
+
 TYPED_TEST_P(simdsort, test_argsort_ascending)
 {
     for (auto type : this->arrtype) {
@@ -128,6 +358,159 @@ TYPED_TEST_P(simdsort, test_argsort_descending)
     }
 }
 
+TYPED_TEST_P(simdsort, test_argsort_buffer)
+{
+    /* one buffer is reused for every call and is never cleared in between */
+    std::vector<size_t> arg(this->arrsize.back(), 42);
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            for (bool descending : {false, true}) {
+                std::vector<TypeParam> sortedarr = arr;
+                if (descending) {
+                    std::sort(sortedarr.begin(),
+                              sortedarr.end(),
+                              compare<TypeParam, std::greater<TypeParam>>());
+                }
+                else {
+                    std::sort(sortedarr.begin(),
+                              sortedarr.end(),
+                              compare<TypeParam, std::less<TypeParam>>());
+                }
+                x86simdsort::argsort(
+                        arr.data(), arg.data(), size, hasnan, descending);
+                IS_ARG_SORTED(sortedarr,
+                              arr,
+                              std::vector<size_t>(arg.begin(),
+                                                  arg.begin() + size),
+                              type);
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argsort_uint32)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : this->arrsize_long) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            for (bool descending : {false, true}) {
+                std::vector<TypeParam> sortedarr = arr;
+                if (descending) {
+                    std::sort(sortedarr.begin(),
+                              sortedarr.end(),
+                              compare<TypeParam, std::greater<TypeParam>>());
+                }
+                else {
+                    std::sort(sortedarr.begin(),
+                              sortedarr.end(),
+                              compare<TypeParam, std::less<TypeParam>>());
+                }
+                std::vector<uint32_t> arg(size);
+                x86simdsort::argsort(
+                        arr.data(), arg.data(), size, hasnan, descending);
+                IS_ARG_SORTED(sortedarr,
+                              arr,
+                              std::vector<size_t>(arg.begin(), arg.end()),
+                              type);
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argsort_parallel)
+{
+    std::vector<size_t> sizes = {0, 1, 100, 10'001, 100'000, 300'000};
+    thread_per_job_executor ex;
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : sizes) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            for (bool descending : {false, true}) {
+                std::vector<TypeParam> sortedarr = arr;
+                if (descending) {
+                    std::sort(sortedarr.begin(),
+                              sortedarr.end(),
+                              compare<TypeParam, std::greater<TypeParam>>());
+                }
+                else {
+                    std::sort(sortedarr.begin(),
+                              sortedarr.end(),
+                              compare<TypeParam, std::less<TypeParam>>());
+                }
+
+                auto arg = x86simdsort::argsort_parallel(
+                        arr.data(), arr.size(), 4, hasnan, descending);
+                IS_ARG_SORTED(sortedarr, arr, arg, type);
+
+                auto arg2 = x86simdsort::argsort_parallel(
+                        arr.data(), arr.size(), ex, hasnan, descending);
+                IS_ARG_SORTED(sortedarr, arr, arg2, type);
+
+                std::vector<size_t> arg3(size, 42);
+                x86simdsort::argsort_parallel(
+                        arr.data(), arg3.data(), size, 4, hasnan, descending);
+                IS_ARG_SORTED(sortedarr, arr, arg3, type);
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argselect_parallel)
+{
+    std::vector<size_t> sizes = {1, 100, 10'001, 300'000};
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : sizes) {
+            size_t k = rand() % size;
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+
+            auto arg = x86simdsort::argselect_parallel(
+                    arr.data(), k, arr.size(), 4, hasnan);
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            IS_ARG_PARTITIONED(arr, arg, sortedarr[k], k, type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_stable_argsort)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            for (bool descending : {false, true}) {
+                std::vector<size_t> expected(size);
+                std::iota(expected.begin(), expected.end(), 0);
+                if (descending) {
+                    std::stable_sort(
+                            expected.begin(),
+                            expected.end(),
+                            compare_arg<TypeParam, std::greater<TypeParam>>(
+                                    arr.data()));
+                }
+                else {
+                    std::stable_sort(
+                            expected.begin(),
+                            expected.end(),
+                            compare_arg<TypeParam, std::less<TypeParam>>(
+                                    arr.data()));
+                }
+                auto arg = x86simdsort::stable_argsort(
+                        arr.data(), size, hasnan, descending);
+                ASSERT_EQ(arg, expected)
+                        << "type = " << type << ", size = " << size
+                        << ", descending = " << descending;
+            }
+        }
+    }
+}
+
 TYPED_TEST_P(simdsort, test_qselect_ascending)
 {
     for (auto type : this->arrtype) {
@@ -206,6 +589,55 @@ TYPED_TEST_P(simdsort, test_argselect)
     }
 }
 
+TYPED_TEST_P(simdsort, test_argselect_buffer)
+{
+    std::vector<size_t> arg(this->arrsize.back(), 42);
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : this->arrsize) {
+            if (size == 0) continue;
+            size_t k = rand() % size;
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+
+            x86simdsort::argselect(arr.data(), arg.data(), k, size, hasnan);
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            IS_ARG_PARTITIONED(
+                    arr,
+                    std::vector<size_t>(arg.begin(), arg.begin() + size),
+                    sortedarr[k],
+                    k,
+                    type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argselect_uint32)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : this->arrsize) {
+            if (size == 0) continue;
+            size_t k = rand() % size;
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+
+            std::vector<uint32_t> arg(size);
+            x86simdsort::argselect(arr.data(), arg.data(), k, size, hasnan);
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            IS_ARG_PARTITIONED(arr,
+                               std::vector<size_t>(arg.begin(), arg.end()),
+                               sortedarr[k],
+                               k,
+                               type);
+        }
+    }
+}
+
 TYPED_TEST_P(simdsort, test_partial_qsort_ascending)
 {
     for (auto type : this->arrtype) {
@@ -258,6 +690,80 @@ TYPED_TEST_P(simdsort, test_partial_qsort_descending)
     }
 }
 
+TYPED_TEST_P(simdsort, test_partial_qsort_topk)
+{
+    // k much smaller than the array takes the top-k filter
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (size_t size : {4096, 100000}) {
+            std::vector<TypeParam> basearr = get_array<TypeParam>(type, size);
+            for (size_t k : {1, 10, 50}) {
+                for (bool descending : {false, true}) {
+                    std::vector<TypeParam> arr = basearr;
+                    std::vector<TypeParam> sortedarr = basearr;
+
+                    x86simdsort::partial_qsort(
+                            arr.data(), k, size, hasnan, descending);
+#ifndef XSS_ASAN_CI_NOCHECK
+                    if (descending) {
+                        std::sort(sortedarr.begin(),
+                                  sortedarr.end(),
+                                  compare<TypeParam,
+                                          std::greater<TypeParam>>());
+                    }
+                    else {
+                        std::sort(sortedarr.begin(),
+                                  sortedarr.end(),
+                                  compare<TypeParam, std::less<TypeParam>>());
+                    }
+                    IS_ARR_PARTIALSORTED(arr, k, sortedarr, type);
+#endif
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_topk_accumulator)
+{
+    for (auto type : this->arrtype) {
+        for (size_t size : {0, 10, 1000, 20000}) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            // NaNs never make it into the top k
+            std::vector<TypeParam> sortedarr;
+            for (auto x : arr) {
+                if (x == x) { sortedarr.push_back(x); }
+            }
+            for (size_t k : {1, 10, 100}) {
+                for (bool descending : {false, true}) {
+                    x86simdsort::topk_accumulator<TypeParam> acc(k,
+                                                                 descending);
+                    // Push chunks of growing size, 1, 3, 7, ...
+                    size_t pos = 0;
+                    for (size_t len = 1; pos < size; len = 2 * len + 1) {
+                        size_t n = std::min(len, size - pos);
+                        acc.push(arr.data() + pos, n);
+                        pos += n;
+                    }
+                    std::vector<TypeParam> topk = acc.finalize();
+#ifndef XSS_ASAN_CI_NOCHECK
+                    if (descending) {
+                        std::sort(sortedarr.begin(),
+                                  sortedarr.end(),
+                                  std::greater<TypeParam>());
+                    }
+                    else {
+                        std::sort(sortedarr.begin(), sortedarr.end());
+                    }
+                    ASSERT_EQ(topk.size(), std::min(k, sortedarr.size()));
+                    IS_ARR_PARTIALSORTED(topk, topk.size(), sortedarr, type);
+#endif
+                }
+            }
+        }
+    }
+}
+
 TYPED_TEST_P(simdsort, test_comparator)
 {
     if constexpr (xss::fp::is_floating_point_v<TypeParam>) {
@@ -294,13 +800,27 @@ TYPED_TEST_P(simdsort, test_comparator)
 REGISTER_TYPED_TEST_SUITE_P(simdsort,
                             test_qsort_ascending,
                             test_qsort_descending,
+                            test_qsort_narrow_range,
+                            test_qsort_presorted,
+                            test_qsort_many_nans,
+                            test_qsort_parallel,
+                            test_qsort_segments,
                             test_argsort_ascending,
                             test_argsort_descending,
                             test_argselect,
+                            test_argsort_buffer,
+                            test_argselect_buffer,
+                            test_argsort_uint32,
+                            test_argselect_uint32,
+                            test_argsort_parallel,
+                            test_argselect_parallel,
+                            test_stable_argsort,
                             test_qselect_ascending,
                             test_qselect_descending,
                             test_partial_qsort_ascending,
                             test_partial_qsort_descending,
+                            test_partial_qsort_topk,
+                            test_topk_accumulator,
                             test_comparator);
 
 using QSortTestTypes = testing::Types<uint16_t,
@@ -317,3 +837,89 @@ using QSortTestTypes = testing::Types<uint16_t,
                                       int64_t>;
 
 INSTANTIATE_TYPED_TEST_SUITE_P(xss, simdsort, QSortTestTypes);
+
+#ifdef __BFLT16_MAX__
+/* __bf16 has qsort, qselect, partial_qsort and the argsort routines only */
+using simdsort_bf16 = simdsort<__bf16>;
+
+TEST_F(simdsort_bf16, test_qsort)
+{
+    using T = __bf16;
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : this->arrsize_long) {
+            std::vector<T> basearr = get_array<T>(type, size);
+
+            std::vector<T> arr = basearr;
+            std::vector<T> sortedarr = basearr;
+            x86simdsort::qsort(arr.data(), arr.size(), hasnan);
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<T, std::less<T>>());
+            IS_SORTED(sortedarr, arr, type);
+
+            arr = basearr;
+            x86simdsort::qsort(arr.data(), arr.size(), hasnan, true);
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<T, std::greater<T>>());
+            IS_SORTED(sortedarr, arr, type);
+        }
+    }
+}
+
+TEST_F(simdsort_bf16, test_qselect_and_partial_qsort)
+{
+    using T = __bf16;
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : this->arrsize) {
+            if (size == 0) continue;
+            size_t k = rand() % size;
+            std::vector<T> basearr = get_array<T>(type, size);
+            std::vector<T> sortedarr = basearr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<T, std::less<T>>());
+
+            std::vector<T> arr = basearr;
+            x86simdsort::qselect(arr.data(), k, arr.size(), hasnan);
+            IS_ARR_PARTITIONED(arr, k, sortedarr[k], type);
+
+            arr = basearr;
+            x86simdsort::partial_qsort(arr.data(), k, arr.size(), hasnan);
+            IS_ARR_PARTIALSORTED(arr, k, sortedarr, type);
+
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<T, std::greater<T>>());
+            arr = basearr;
+            x86simdsort::qselect(arr.data(), k, arr.size(), hasnan, true);
+            IS_ARR_PARTITIONED(arr, k, sortedarr[k], type, true);
+
+            arr = basearr;
+            x86simdsort::partial_qsort(
+                    arr.data(), k, arr.size(), hasnan, true);
+            IS_ARR_PARTIALSORTED(arr, k, sortedarr, type);
+        }
+    }
+}
+
+TEST_F(simdsort_bf16, test_argsort)
+{
+    using T = __bf16;
+    for (auto type : this->arrtype) {
+        bool hasnan = is_nan_test(type);
+        for (auto size : this->arrsize) {
+            std::vector<T> arr = get_array<T>(type, size);
+            std::vector<T> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<T, std::less<T>>());
+
+            auto arg = x86simdsort::argsort(arr.data(), arr.size(), hasnan);
+            IS_ARG_SORTED(sortedarr, arr, arg, type);
+        }
+    }
+}
+#endif
@@ -0,0 +1,89 @@
+/*******************************************
+ * * Copyright (C) 2022-2023 Intel Corporation
+ * * SPDX-License-Identifier: BSD-3-Clause
+ * *******************************************/
+
+#include "rand_array.h"
+#include "xss-radix-sort.hpp"
+#include <gtest/gtest.h>
+
+/*
+ * qsort and keyvalue_qsort only radix sort when built with
+ * XSS_RADIX_SORT_MIN_SIZE, so these tests call the sort directly.
+ */
+template <typename T>
+class radixsort : public ::testing::Test {
+public:
+    radixsort()
+    {
+        arrtype = {"random", "constant", "sorted", "reverse", "smallrange"};
+        arrsize = {1, 2, 255, 256, 257, 1000, 10000};
+    }
+    std::vector<std::string> arrtype;
+    std::vector<size_t> arrsize;
+};
+
+TYPED_TEST_SUITE_P(radixsort);
+
+TYPED_TEST_P(radixsort, test_keys)
+{
+    using T = TypeParam;
+    constexpr bool is_float = xss::fp::is_floating_point_v<T>;
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            std::vector<T> arr = get_array<T>(type, size);
+            std::vector<T> sorted = arr;
+            std::sort(sorted.begin(), sorted.end());
+            ASSERT_TRUE((xss_radix_sort<T, is_float, false>(
+                    arr.data(), (xss_radix_no_values *)nullptr, size)));
+            EXPECT_EQ(arr, sorted) << type << " " << size;
+
+            std::reverse(sorted.begin(), sorted.end());
+            ASSERT_TRUE((xss_radix_sort<T, is_float, true>(
+                    arr.data(), (xss_radix_no_values *)nullptr, size)));
+            EXPECT_EQ(arr, sorted) << type << " " << size;
+        }
+    }
+}
+
+TYPED_TEST_P(radixsort, test_key_values)
+{
+    using T = TypeParam;
+    constexpr bool is_float = xss::fp::is_floating_point_v<T>;
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            std::vector<T> keys = get_array<T>(type, size);
+            std::vector<uint64_t> vals(size);
+            std::vector<std::pair<T, uint64_t>> pairs(size);
+            for (size_t ii = 0; ii < size; ++ii) {
+                vals[ii] = ii;
+                pairs[ii] = {keys[ii], ii};
+            }
+            /* the radix sort is stable in both directions */
+            std::stable_sort(pairs.begin(),
+                             pairs.end(),
+                             [](const auto &a, const auto &b) {
+                                 return a.first > b.first;
+                             });
+            ASSERT_TRUE((xss_radix_sort<T, is_float, true>(
+                    keys.data(), vals.data(), size)));
+            for (size_t ii = 0; ii < size; ++ii) {
+                ASSERT_EQ(keys[ii], pairs[ii].first) << type << " " << ii;
+                ASSERT_EQ(vals[ii], pairs[ii].second) << type << " " << ii;
+            }
+        }
+    }
+}
+
+REGISTER_TYPED_TEST_SUITE_P(radixsort, test_keys, test_key_values);
+
+using RadixSortTestTypes = testing::Types<uint16_t,
+                                          int16_t,
+                                          float,
+                                          double,
+                                          uint32_t,
+                                          int32_t,
+                                          uint64_t,
+                                          int64_t>;
+
+INSTANTIATE_TYPED_TEST_SUITE_P(xss, radixsort, RadixSortTestTypes);
@@ -38,6 +38,16 @@ static std::vector<T> get_uniform_rand_array(int64_t arrsize,
             arr.push_back((_Float16)temp);
         }
     }
+#endif
+#ifdef __BFLT16_MAX__
+    else if constexpr (std::is_same_v<T, __bf16>) {
+        (void)(max);
+        (void)(min);
+        for (auto jj = 0; jj < arrsize; ++jj) {
+            float temp = (float)rand() / (float)(RAND_MAX);
+            arr.push_back((__bf16)temp);
+        }
+    }
 #endif
     else if constexpr (std::is_integral_v<T>) {
         std::default_random_engine e1(rd());